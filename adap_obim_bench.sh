@@ -0,0 +1,49 @@
+#!/bin/bash
+red=`tput setaf 1`
+green=`tput setaf 2`
+reset=`tput sgr0`
+
+# Push rate of PMOD BFS with and without the per-thread lock AdaptiveObim
+# used to take on every push and pop. The locked bfs is built in a second
+# build directory with -DADAPOBIM_PUSH_LOCK. Run install_cps.sh and
+# install_benchmarks.sh first; the latter also builds adap-obim-check.
+
+export MAIN_DIR=`pwd`
+export PMOD_HOME=$MAIN_DIR/PMOD/Galois-2.2.1
+export PMOD_DIR=$MAIN_DIR/PMOD/Galois-2.2.1/build/apps
+export PMOD_LOCK_DIR=$MAIN_DIR/PMOD/Galois-2.2.1/build_push_lock/apps
+
+echo "${green}Compiling BFS with the push lock${reset}"
+mkdir -p $PMOD_HOME/build_push_lock
+cd $PMOD_HOME/build_push_lock
+cmake -DCMAKE_CXX_FLAGS=-DADAPOBIM_PUSH_LOCK ../
+cd apps/bfs;
+make clean; make -j32;
+
+echo "${green}Compiling BFS without the push lock${reset}"
+cd $PMOD_DIR/bfs;
+make clean; make -j32;
+
+cd $MAIN_DIR
+
+mkdir -p output
+echo "" > output/adap_obim_bench.out
+
+echo "${green}Checking AdaptiveObim with and without unmerging${reset}"
+$PMOD_DIR/sssp/adap-obim-check -t 40 | grep 'tasks popped\|Verification' >> output/adap_obim_bench.out
+
+for t in 1 10 20 40; do
+  for wl in lock nolock; do
+    BFS=$PMOD_DIR/bfs/bfs
+    if [ $wl == lock ]; then
+      BFS=$PMOD_LOCK_DIR/bfs/bfs
+    fi
+    echo "${green}Running BFS with PMOD ($wl, $t threads)${reset}"
+    echo "Running BFS with PMOD ($wl, $t threads)" >> output/adap_obim_bench.out
+    $BFS $MAIN_DIR/datasets/USA-road-dUSA.bin -t $t -startNode 0 -wl adap-obim -delta 0 -algo async > temp
+    cat temp | grep 'Elapsed Time' >> output/adap_obim_bench.out
+    cat temp | grep 'pushes/sec' | tail -n1 >> output/adap_obim_bench.out
+  done
+done
+
+cat output/adap_obim_bench.out
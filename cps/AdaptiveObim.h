@@ -23,7 +23,10 @@
 #ifndef GALOIS_WORKLIST_ADAPTIVEOBIM_H
 #define GALOIS_WORKLIST_ADAPTIVEOBIM_H
 
-// #define UNMERGE_ENABLED
+// Take the per-thread lock around every push and pop again, as before delta
+// updates were published through the epoch. Only kept to measure its cost
+// (adap_obim_bench.sh).
+// #define ADAPOBIM_PUSH_LOCK
 
 //#define OBIM_ADAP_DBG
 #ifdef OBIM_ADAP_DBG
@@ -36,7 +39,9 @@
 #include "Galois/FlatMap.h"
 #include "Galois/Timer.h"
 #include "Galois/Runtime/PerThreadStorage.h"
+#include "Galois/Runtime/ll/CacheLineStorage.h"
 #include "Galois/WorkList/Fifo.h"
+#include "Galois/WorkList/Obim.h"
 #include "Galois/WorkList/WorkListHelpers.h"
 
 #include "Galois/Statistic.h"
@@ -44,7 +49,9 @@
 #include GALOIS_CXX11_STD_HEADER(type_traits)
 #include <limits>
 
+#include <algorithm>
 #include <atomic>
+#include <vector>
 
 #include <iostream>
 #include <math.h>
@@ -75,6 +82,7 @@ namespace WorkList {
  * @tparam BlockPeriod Check for higher priority work every 2^BlockPeriod
  *                     iterations
  * @tparam BSP Use back-scan prevention
+ * @tparam Unmerge Also lower delta again when a few bins take all the work
  */
 template<class Indexer = DummyIndexer<int>, typename Container = FIFO<>,
   int BlockPeriod=0,
@@ -83,25 +91,26 @@ template<class Indexer = DummyIndexer<int>, typename Container = FIFO<>,
   int chunk_size=64,
   typename T=int,
   typename Index=int,
-  bool Concurrent=true>
+  bool Concurrent=true,
+  bool Unmerge=false>
 struct AdaptiveOrderedByIntegerMetric : private boost::noncopyable {
   template<bool _concurrent>
-  struct rethread { typedef AdaptiveOrderedByIntegerMetric<Indexer, typename Container::template rethread<_concurrent>::type, BlockPeriod, BSP, uniformBSP, chunk_size,T, Index, _concurrent> type; };
+  struct rethread { typedef AdaptiveOrderedByIntegerMetric<Indexer, typename Container::template rethread<_concurrent>::type, BlockPeriod, BSP, uniformBSP, chunk_size,T, Index, _concurrent, Unmerge> type; };
 
   template<typename _T>
-  struct retype { typedef AdaptiveOrderedByIntegerMetric<Indexer, typename Container::template retype<_T>::type, BlockPeriod, BSP, uniformBSP,chunk_size, _T, typename std::result_of<Indexer(_T)>::type, Concurrent> type; };
+  struct retype { typedef AdaptiveOrderedByIntegerMetric<Indexer, typename Container::template retype<_T>::type, BlockPeriod, BSP, uniformBSP,chunk_size, _T, typename std::result_of<Indexer(_T)>::type, Concurrent, Unmerge> type; };
 
   template<unsigned _period>
-  struct with_block_period { typedef AdaptiveOrderedByIntegerMetric<Indexer, Container, _period, BSP, uniformBSP, chunk_size,T, Index, Concurrent> type; };
+  struct with_block_period { typedef AdaptiveOrderedByIntegerMetric<Indexer, Container, _period, BSP, uniformBSP, chunk_size,T, Index, Concurrent, Unmerge> type; };
 
   template<typename _container>
-  struct with_container { typedef AdaptiveOrderedByIntegerMetric<Indexer, _container, BlockPeriod, BSP, uniformBSP, chunk_size,T, Index, Concurrent> type; };
+  struct with_container { typedef AdaptiveOrderedByIntegerMetric<Indexer, _container, BlockPeriod, BSP, uniformBSP, chunk_size,T, Index, Concurrent, Unmerge> type; };
 
   template<typename _indexer>
-  struct with_indexer { typedef AdaptiveOrderedByIntegerMetric<_indexer, Container, BlockPeriod, BSP, uniformBSP, chunk_size,T, Index, Concurrent> type; };
+  struct with_indexer { typedef AdaptiveOrderedByIntegerMetric<_indexer, Container, BlockPeriod, BSP, uniformBSP, chunk_size,T, Index, Concurrent, Unmerge> type; };
 
   template<bool _bsp>
-  struct with_back_scan_prevention { typedef AdaptiveOrderedByIntegerMetric<Indexer, Container, BlockPeriod, _bsp, uniformBSP, chunk_size,T, Index, Concurrent> type; };
+  struct with_back_scan_prevention { typedef AdaptiveOrderedByIntegerMetric<Indexer, Container, BlockPeriod, _bsp, uniformBSP, chunk_size,T, Index, Concurrent, Unmerge> type; };
 
   typedef T value_type;
 
@@ -110,7 +119,12 @@ private:
   bool sync = false;
   unsigned int pd = 0;
 
-  unsigned int delta;
+  // Delta is published RCU style: thread 0 stores a new value and then bumps
+  // the epoch, and every thread adopts it the next time it touches the
+  // worklist. Bins made under an older delta stay valid, so a thread still
+  // using the old value for a few more tasks is harmless.
+  std::atomic<unsigned int> delta;
+  std::atomic<unsigned int> epoch;
   unsigned int counter;
   unsigned int maxIndex;
   unsigned int lastSizeMasterLog;
@@ -194,6 +208,36 @@ private:
   //typedef Galois::flat_map<Index, std::atomic<unsigned int>> CntrMapTy;
   //typedef std::map<Index, CTy*> LMapTy;
 
+  // What a thread tells thread 0 for the delta adaptation. Only the owner
+  // writes, so plain load/store pairs suffice and thread 0 reads it without
+  // stopping anyone. The counts only grow; thread 0 diffs them against its
+  // last snapshot. minPrio/maxPrio cover the epoch in the epoch field.
+  struct AdaptStats {
+    std::atomic<unsigned long> pushes;
+    std::atomic<unsigned long> prios;
+    std::atomic<unsigned long> deqs;
+    std::atomic<Index> minPrio;
+    std::atomic<Index> maxPrio;
+    std::atomic<unsigned int> epoch;
+    std::atomic<unsigned int> retired; // retiredLog entries this thread dropped
+
+    AdaptStats(): pushes(0), prios(0), deqs(0),
+      minPrio(std::numeric_limits<Index>::max()),
+      maxPrio(std::numeric_limits<Index>::min()), epoch(0), retired(0) {}
+  };
+
+  // Thread 0's view of a thread's counts at the last adaptation
+  struct AdaptSnapshot {
+    unsigned long pushes;
+    unsigned long prios;
+    AdaptSnapshot(): pushes(0), prios(0) {}
+  };
+
+  template<typename V>
+  static void bump(std::atomic<V>& c) {
+    c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
   struct perItem {
     LMapTy local;
     //CntrMapTy counter; // for every push increase counter
@@ -203,27 +247,25 @@ private:
     unsigned int lastMasterVersion;
     unsigned int numPops;
 
-    //per thread lock
-
     unsigned int sinceLastFix;
     unsigned int slowPopsLastPeriod;
-    unsigned int pushesLastPeriod;
-    unsigned int priosLastPeriod;
-
-    unsigned long pmodAllDeq;
 
     unsigned int popsFromSameQ;
     unsigned int ctr;
 
-    Index maxPrioDiffLastPeriod;
-    Index minPrio;
-    Index maxPrio;
+    // delta and epoch this thread currently works with
+    unsigned int delta;
+    unsigned int epoch;
+    unsigned int lastRetiredVersion;
+    Runtime::LL::CacheLineStorage<AdaptStats> stats;
+#ifdef ADAPOBIM_PUSH_LOCK
     Runtime::LL::PaddedLock<Concurrent> lock;
+#endif
 
     int pd_counter = 0;
     unsigned int latest_index = 0;
 
-    perItem()
+    perItem(): delta(0), epoch(0), lastRetiredVersion(0)
       //curIndex(std::numeric_limits<Index>::min()),
       //scanStart(std::numeric_limits<Index>::min()),
       //current(0), lastMasterVersion(0), numPops(0), sinceLastFix(0),
@@ -240,10 +282,60 @@ private:
   Runtime::LL::PaddedLock<Concurrent> masterLock;
   Galois::Timer clock;
   MasterLog masterLog;
+  // Bins of an older delta that thread 0 took out of service. Each thread
+  // drops them from its map and moves out what only it can pop (its partly
+  // filled chunks); once all have, thread 0 frees them and clears their
+  // masterLog entries.
+  OrderedByIntegerMetricLog<CTy*> retiredLog; // thread 0 appends
+  std::atomic<unsigned int> retiredVersion;
+  unsigned int reclaimed; // thread 0 only
+  bool compactPending; // thread 0 only
+  unsigned long liveBins; // under masterLock
+  unsigned long maxLiveBins;
+  // (epoch, live bins) after every reclaim, printed at teardown; thread 0 only
+  std::vector<std::pair<unsigned int, unsigned long> > liveSeries;
 
   Runtime::MM::FixedSizeAllocator heap;
   std::atomic<unsigned int> masterVersion;
   Indexer indexer;
+  std::vector<AdaptSnapshot> seen; // thread 0 only
+
+  //! Adopt the delta thread 0 published last, if it is new to this thread
+  void updateDelta(perItem& p) {
+    unsigned int e = epoch.load(std::memory_order_acquire);
+    if (e == p.epoch)
+      return;
+    p.epoch = e;
+    p.delta = delta.load(std::memory_order_relaxed);
+    AdaptStats& s = p.stats.data;
+    s.minPrio.store(std::numeric_limits<Index>::max(), std::memory_order_relaxed);
+    s.maxPrio.store(std::numeric_limits<Index>::min(), std::memory_order_relaxed);
+    s.epoch.store(e, std::memory_order_release);
+  }
+
+  //! Start a new adaptation period with delta d. Called by thread 0 only.
+  void publishDelta(perItem& p, unsigned int d) {
+    delta.store(d, std::memory_order_relaxed);
+    epoch.store(epoch.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    p.sinceLastFix = 0;
+    p.slowPopsLastPeriod = 0;
+    compactPending = true;
+    updateDelta(p);
+  }
+
+  // No other thread writes a perItem, so push and pop need no lock; delta
+  // changes arrive through updateDelta.
+  void lockLocal(perItem& p) {
+#ifdef ADAPOBIM_PUSH_LOCK
+    while (!p.lock.try_lock());
+#endif
+  }
+
+  void unlockLocal(perItem& p) {
+#ifdef ADAPOBIM_PUSH_LOCK
+    p.lock.unlock();
+#endif
+  }
 
   bool updateLocal(perItem& p) {
     if (p.lastMasterVersion != masterVersion.load(std::memory_order_relaxed)) {
@@ -277,99 +369,78 @@ private:
     if(myID == 0 && p.sinceLastFix>counter
       && ((double)(p.slowPopsLastPeriod)/(double)(p.sinceLastFix)) > 1.0/(double)(chunk_size)){
       //std::cout<<"Master Log Size: "<<masterLog.size()<<std::endl;
-      for (unsigned i = 1; i < Runtime::activeThreads; ++i){
-        while(!current.getRemote(i)->lock.try_lock());;
-      }
       unsigned long priosCreatedThisPeriod=0;
       unsigned long numPushesThisStep=0;
       unsigned long allPmodDeqCounts = 0;
       Index minOfMin = std::numeric_limits<Index>::max();
       Index maxOfMax = std::numeric_limits<Index>::min();
-      ERR_MSG<<"Locked everyone else"<<std::endl;
+      unsigned int e = epoch.load(std::memory_order_relaxed);
+      unsigned int d = delta.load(std::memory_order_relaxed);
       for(unsigned i=0; i<Runtime::activeThreads; ++i){
-      //  ERR_MSG<<"Thread i: "<<i<<" numPopsSinceLastFix "<<current.getRemote(i)->sinceLastFix<<std::endl;
-      //  ERR_MSG<<"\tThread i: "<<i<<" pushesLastPeriod "<<current.getRemote(i)->pushesLastPeriod<<std::endl;
-      //  ERR_MSG<<"\tThread i: "<<i<<" priosLastPeriod "<<current.getRemote(i)->priosLastPeriod<<std::endl;
-        minOfMin = std::min(minOfMin,current.getRemote(i)->minPrio);
-        maxOfMax = std::max(maxOfMax, current.getRemote(i)->maxPrio);
-        //ERR_MSG<<"\tThread i: "<<i<<" maxPrioDiffLastPeriod "<<current.getRemote(i)->maxPrioDiffLastPeriod<<std::endl;
-        priosCreatedThisPeriod+=current.getRemote(i)->priosLastPeriod;
-        numPushesThisStep+=current.getRemote(i)->pushesLastPeriod;
-        allPmodDeqCounts+=current.getRemote(i)->pmodAllDeq;
-        current.getRemote(i)->sinceLastFix=0;
-        current.getRemote(i)->slowPopsLastPeriod=0;
-        current.getRemote(i)->pushesLastPeriod=0;
-        current.getRemote(i)->priosLastPeriod=0;
-        current.getRemote(i)->maxPrioDiffLastPeriod=0;
-
-        current.getRemote(i)->minPrio = std::numeric_limits<Index>::max();
-        current.getRemote(i)->maxPrio = std::numeric_limits<Index>::min();
+        AdaptStats& st = current.getRemote(i)->stats.data;
+        // a thread that has not seen the current epoch has not pushed in it
+        if (st.epoch.load(std::memory_order_acquire) == e) {
+          minOfMin = std::min(minOfMin, st.minPrio.load(std::memory_order_relaxed));
+          maxOfMax = std::max(maxOfMax, st.maxPrio.load(std::memory_order_relaxed));
+        }
+        unsigned long pushes = st.pushes.load(std::memory_order_relaxed);
+        unsigned long prios = st.prios.load(std::memory_order_relaxed);
+        numPushesThisStep += pushes - seen[i].pushes;
+        priosCreatedThisPeriod += prios - seen[i].prios;
+        allPmodDeqCounts += st.deqs.load(std::memory_order_relaxed);
+        seen[i].pushes = pushes;
+        seen[i].prios = prios;
       }
 
-      if(((double)numPushesThisStep/((double)((maxOfMax>>delta)-(minOfMin>>delta))))< chunk_size/2){
-        double xx = ((double)(chunk_size)/((double)numPushesThisStep/((double)((maxOfMax>>delta)-(minOfMin>>delta)))));
+      if(((double)numPushesThisStep/((double)((maxOfMax>>d)-(minOfMin>>d))))< chunk_size/2){
+        double xx = ((double)(chunk_size)/((double)numPushesThisStep/((double)((maxOfMax>>d)-(minOfMin>>d)))));
         ERR_MSG<<"Chunk size over "<<xx<<std::endl;
         ERR_MSG<<"Delta increase: "<<std::log2(xx)<<std::endl;
-        delta+=std::floor(std::log2(xx));
-        std::cout<<"Delta "<<delta<<" "<<(allPmodDeqCounts)<<std::endl;
+        d+=std::floor(std::log2(xx));
+        std::cout<<"Delta "<<d<<" "<<(allPmodDeqCounts)<<std::endl;
         counter*=2;
         //ERR_MSG<<"Increase delta by "<<((maxOfMax>>delta) - (minOfMin>>delta))/16<<std::endl;
       }
+      publishDelta(p, d);
 
-      for (unsigned i = 1; i < Runtime::activeThreads; ++i){
-        current.getRemote(i)->lock.unlock();
-      }
       //counter*=2;
       ERR_MSG<<"Priorities created for this step "<<priosCreatedThisPeriod<<std::endl;
       ERR_MSG<<"Push/Prio ratio "<<((double)(priosCreatedThisPeriod)/(double)(numPushesThisStep))<<std::endl;
-      ERR_MSG<<"Min "<<minOfMin<<" max "<<maxOfMax<<" bins "<<(minOfMin>>delta)<<" "<<(maxOfMax>>delta)<<" pushes "<<numPushesThisStep<<" Ratio "<<((double)numPushesThisStep/((double)((maxOfMax>>delta)-(minOfMin>>delta))))<< std::endl;
-      ERR_MSG<<"Unlocked everyone else"<<std::endl;
+      ERR_MSG<<"Min "<<minOfMin<<" max "<<maxOfMax<<" bins "<<(minOfMin>>d)<<" "<<(maxOfMax>>d)<<" pushes "<<numPushesThisStep<<" Ratio "<<((double)numPushesThisStep/((double)((maxOfMax>>d)-(minOfMin>>d))))<< std::endl;
     }
-    #ifdef UNMERGE_ENABLED
     // serif added here
     // make sure delta is bigger than 0 so that we can actually unmerge things
     // give it some time and check the same queue pops
-    else if(delta > 0 && myID == 0 && p.sinceLastFix>counter&& p.popsFromSameQ > 4*chunk_size){
+    else if(Unmerge && p.delta > 0 && myID == 0 && p.sinceLastFix>counter&& p.popsFromSameQ > 4*chunk_size){
       // std::cout<<"1Same queue dequeue"<<std::endl;
-      if(((p.maxPrio>>delta)-(p.minPrio>>delta))<16
-         && ((double)p.pushesLastPeriod/((double)((p.maxPrio>>delta)-(p.minPrio>>delta))))> 4*chunk_size){ // this is a check to make sure we are also pushing with the same frequency end of execution
+      AdaptStats& st = p.stats.data;
+      unsigned int d = p.delta;
+      Index minPrio = st.minPrio.load(std::memory_order_relaxed);
+      Index maxPrio = st.maxPrio.load(std::memory_order_relaxed);
+      unsigned long pushes = st.pushes.load(std::memory_order_relaxed) - seen[0].pushes;
+      if(((maxPrio>>d)-(minPrio>>d))<16
+         && ((double)pushes/((double)((maxPrio>>d)-(minPrio>>d))))> 4*chunk_size){ // this is a check to make sure we are also pushing with the same frequency end of execution
         // std::cout<<"Same queue dequeue "<<p.ctr<<" "<<masterLog.size()<<std::endl;
-        // std::cout<<((p.maxPrio>>delta)-(p.minPrio>>delta))<<std::endl;
-        double diff = ((p.maxPrio>>delta)-(p.minPrio>>delta))>=1 ? ((p.maxPrio>>delta)-(p.minPrio>>delta)) : 1;
+        // std::cout<<((maxPrio>>d)-(minPrio>>d))<<std::endl;
+        double diff = ((maxPrio>>d)-(minPrio>>d))>=1 ? ((maxPrio>>d)-(minPrio>>d)) : 1;
         double xx = 16 / diff;
-        std::cout<<delta<<" "<<std::floor(std::log2(xx))<<" "<<xx<<std::endl;
-        if(delta>(unsigned int)(std::floor(std::log2(xx))))
-          delta -= (unsigned int)(std::floor(std::log2(xx)));
+        std::cout<<d<<" "<<std::floor(std::log2(xx))<<" "<<xx<<std::endl;
+        if(d>(unsigned int)(std::floor(std::log2(xx))))
+          d -= (unsigned int)(std::floor(std::log2(xx)));
         else
-          delta=0;
-        std::cout<<"Delta decreased to"<<delta<<std::endl;
+          d=0;
+        std::cout<<"Delta decreased to"<<d<<std::endl;
 
-        for (unsigned i = 1; i < Runtime::activeThreads; ++i){
-          while(!current.getRemote(i)->lock.try_lock());;
-        }
-      
-        ERR_MSG<<"Locked everyone else"<<std::endl;
         for(unsigned i=0; i<Runtime::activeThreads; ++i){
-        
-          current.getRemote(i)->sinceLastFix=0;
-          current.getRemote(i)->slowPopsLastPeriod=0;
-          current.getRemote(i)->pushesLastPeriod=0;
-          current.getRemote(i)->priosLastPeriod=0;
-          current.getRemote(i)->maxPrioDiffLastPeriod=0;
-
-          current.getRemote(i)->minPrio = std::numeric_limits<Index>::max();
-          current.getRemote(i)->maxPrio = std::numeric_limits<Index>::min();
-          // current.getRemote(i)->lock.unlock();
-        }
-
-        for (unsigned i = 1; i < Runtime::activeThreads; ++i){
-          current.getRemote(i)->lock.unlock();
+          AdaptStats& sti = current.getRemote(i)->stats.data;
+          seen[i].pushes = sti.pushes.load(std::memory_order_relaxed);
+          seen[i].prios = sti.prios.load(std::memory_order_relaxed);
         }
+        publishDelta(p, d);
         p.ctr++;
       }
       p.popsFromSameQ=0;
     }
-    #endif
     p.popsFromSameQ=0;
     // if(myID == 0 && p.sinceLastFix>counter
     //   && ((double)(p.slowPopsLastPeriod)/(double)(p.sinceLastFix)) > 1.0/(double)(chunk_size)){
@@ -377,6 +448,9 @@ private:
     // }
 
     //p.lastNumPops=p.numPops;
+    retireLocal(p);
+    if (myID == 0)
+      compact(p);
     updateLocal(p);
     //unsigned myID = Runtime::LL::getTID();
     bool localLeader = Runtime::LL::isPackageLeaderForSelf(myID);
@@ -401,11 +475,11 @@ private:
         p.current = ii->second;
         p.curIndex = ii->first;
         p.scanStart = ii->first;
-        p.lock.unlock();
+        unlockLocal(p);
         return retval;
       }
     }
-    p.lock.unlock();
+    unlockLocal(p);
     return Galois::optional<value_type>();
   }
 
@@ -426,14 +500,117 @@ private:
       p.lastMasterVersion = masterVersion.load(std::memory_order_relaxed) + 1;
       masterLog.push_back(std::make_pair(i, lC2));
       masterVersion.fetch_add(1);
+      maxLiveBins = std::max(maxLiveBins, ++liveBins);
       (*numberOfPris)+=1;
-      p.priosLastPeriod++;
+      bump(p.stats.data.prios);
       //perPriorityCntr[i]=0;
     }
     masterLock.unlock();
     return lC2;
   }
 
+  void pushLocal(perItem& p, deltaIndex index, const value_type& val) {
+    // Fast path
+    if (index == p.curIndex && p.current) {
+      p.current->push(val);
+      return;
+    }
+
+    // Slow path
+    CTy* lC = updateLocalOrCreate(p, index);
+    if (BSP && index < p.scanStart)
+      p.scanStart = index;
+    // Opportunistically move to higher priority work
+    if (index < p.curIndex) {
+      //we moved to a higher prio
+      p.popsFromSameQ=0;
+
+      p.curIndex = index;
+      p.current = lC;
+    }
+    lC->push(val);
+  }
+
+  //! Move what this thread can still pop from a bin into bins of its delta
+  void moveOut(perItem& p, CTy* C) {
+    std::vector<value_type> moved;
+    Galois::optional<value_type> item;
+    while ((item = C->pop()))
+      moved.push_back(*item);
+    for (auto& val : moved)
+      pushLocal(p, deltaIndex(val(), p.delta), val);
+  }
+
+  //! Drop the bins thread 0 retired since this thread last looked
+  void retireLocal(perItem& p) {
+    unsigned int v = retiredVersion.load(std::memory_order_acquire);
+    if (p.lastRetiredVersion == v)
+      return;
+    updateDelta(p);
+    updateLocal(p);
+    std::vector<CTy*> gone;
+    for (; p.lastRetiredVersion < v; ++p.lastRetiredVersion)
+      gone.push_back(retiredLog[p.lastRetiredVersion]);
+    std::sort(gone.begin(), gone.end());
+    // bins of different deltas do not order strictly, so rather than look
+    // each one up, rebuild the map without them
+    LMapTy keep;
+    for (auto ii = p.local.begin(), ee = p.local.end(); ii != ee; ++ii)
+      if (!std::binary_search(gone.begin(), gone.end(), ii->second))
+        keep.insert(keep.end(), *ii);
+    p.local.swap(keep);
+    if (std::binary_search(gone.begin(), gone.end(), p.current))
+      p.current = 0;
+    for (CTy* C : gone)
+      moveOut(p, C);
+    p.stats.data.retired.store(v, std::memory_order_release);
+  }
+
+  //! Thread 0 only: retire the bins of older deltas and free the ones every
+  //! thread has dropped
+  void compact(perItem& p) {
+    if (compactPending) {
+      MasterLog stale;
+      for (auto ii = p.local.begin(), ee = p.local.end(); ii != ee; ++ii)
+        if (ii->first.d != p.delta)
+          stale.push_back(*ii);
+      // threads still on the old delta may make more, so look again later
+      compactPending = !stale.empty();
+      if (!stale.empty()) {
+        for (auto ii = stale.begin(), ee = stale.end(); ii != ee; ++ii)
+          retiredLog.push_back(ii->second);
+        retiredVersion.store(retiredLog.size(), std::memory_order_release);
+        retireLocal(p);
+      }
+    }
+
+    unsigned int done = retiredVersion.load(std::memory_order_relaxed);
+    for (unsigned i = 0; i < Runtime::activeThreads; ++i)
+      done = std::min(done, current.getRemote(i)->stats.data.retired.load(std::memory_order_acquire));
+    if (done == reclaimed)
+      return;
+
+    std::vector<CTy*> dead;
+    for (; reclaimed < done; ++reclaimed) {
+      CTy* C = retiredLog[reclaimed];
+      // everyone moved out their own part already; this is only a safety net
+      moveOut(p, C);
+      dead.push_back(C);
+    }
+    std::sort(dead.begin(), dead.end());
+    while (!masterLock.try_lock());
+    for (auto& e : masterLog)
+      if (e.second && std::binary_search(dead.begin(), dead.end(), e.second))
+        e.second = 0;
+    liveBins -= dead.size();
+    masterLock.unlock();
+    for (CTy* C : dead) {
+      C->~CTy();
+      heap.deallocate(C);
+    }
+    liveSeries.push_back(std::make_pair(epoch.load(std::memory_order_relaxed), liveBins));
+  }
+
   inline CTy* updateLocalOrCreate(perItem& p, deltaIndex i) {
     //Try local then try update then find again or else create and update the master log
     CTy* lC;
@@ -446,9 +623,8 @@ private:
 public:
   static Galois::Statistic* numberOfPris;
   static Galois::Statistic* pmodNumDeq;
-  AdaptiveOrderedByIntegerMetric(const Indexer& x = Indexer()): heap(sizeof(CTy)), masterVersion(0), indexer(x) {
+  AdaptiveOrderedByIntegerMetric(const Indexer& x = Indexer()): delta(0), epoch(0), retiredVersion(0), reclaimed(0), compactPending(false), liveBins(0), maxLiveBins(0), heap(sizeof(CTy)), masterVersion(0), indexer(x), seen(Runtime::activeThreads) {
     clock.start();
-    delta=0;
     counter= chunk_size;
     if(numberOfPris == 0){
       numberOfPris = new Galois::Statistic("numberOfPris");
@@ -470,11 +646,29 @@ public:
     //Print stats for priroity counts here
     for (auto ii = masterLog.rbegin(), ei = masterLog.rend(); ii != ei; ++ii) {
       CTy* lC = ii->second;
+      if (!lC)
+        continue;
       lC->~CTy();
       heap.deallocate(lC);
     }
 
     std::cout<<"Final delta "<<delta<<std::endl;
+    std::cout<<"Max live bins "<<maxLiveBins<<" retired "<<reclaimed<<std::endl;
+    std::cout<<"Live bins by epoch:";
+    for (auto ii = liveSeries.begin(), ee = liveSeries.end(); ii != ee; ++ii)
+      std::cout<<" "<<ii->first<<":"<<ii->second;
+    std::cout<<std::endl;
+
+    clock.stop();
+    unsigned long pushes = 0, pops = 0;
+    for (unsigned i = 0; i < Runtime::activeThreads; ++i) {
+      AdaptStats& st = current.getRemote(i)->stats.data;
+      pushes += st.pushes.load(std::memory_order_relaxed);
+      pops += st.deqs.load(std::memory_order_relaxed);
+    }
+    unsigned long ms = std::max(clock.get(), 1UL);
+    std::cout<<"Pushes "<<pushes<<" pops "<<pops<<" in "<<ms<<" ms, "
+             <<(pushes * 1000 / ms)<<" pushes/sec"<<std::endl;
     //print incomplete pop
     // for (unsigned i = 0; i < Runtime::activeThreads; ++i){
     //   std::cout<<"Thread i:"<<i<<" incomplete pops: "<<current.getRemote(i)->incompleteChunks<<" consec. incomplete pops: "<<current.getRemote(i)->consec1IncompleteChunks<<std::endl;
@@ -494,12 +688,13 @@ public:
 
   void push(const value_type& val) {
     perItem& p = *current.getLocal();
-    while (!p.lock.try_lock());
+    lockLocal(p);
+    updateDelta(p);
     Index ind = val();
     //(val()>>delta)+maxIndex;//indexer(val);
     deltaIndex index;
     index.k = ind;
-    index.d = delta;
+    index.d = p.delta;
     // assert(index.k>p.curIndex.k);
     // Index kk = (index.k>>delta);
     // Index ll =(p.curIndex.k>>delta);
@@ -512,35 +707,16 @@ public:
     //
     //   //
     // }
-    if(index.k > p.maxPrio){
-      p.maxPrio = index.k;
-    }
-    if(index.k< p.minPrio){
-      p.minPrio = index.k;
+    AdaptStats& st = p.stats.data;
+    if(index.k > st.maxPrio.load(std::memory_order_relaxed)){
+      st.maxPrio.store(index.k, std::memory_order_relaxed);
     }
-    p.pushesLastPeriod++;
-
-    // Fast path
-    if (index == p.curIndex && p.current) {
-      p.current->push(val);
-      p.lock.unlock();
-      return;
-    }
-
-    // Slow path
-    CTy* lC = updateLocalOrCreate(p, index);
-    if (BSP && index < p.scanStart)
-      p.scanStart = index;
-    // Opportunistically move to higher priority work
-    if (index < p.curIndex) {
-      //we moved to a higher prio
-      p.popsFromSameQ=0;
-
-      p.curIndex = index;
-      p.current = lC;
+    if(index.k < st.minPrio.load(std::memory_order_relaxed)){
+      st.minPrio.store(index.k, std::memory_order_relaxed);
     }
-    lC->push(val);
-    p.lock.unlock();
+    bump(st.pushes);
+    pushLocal(p, index, val);
+    unlockLocal(p);
   }
 
   template<typename Iter>
@@ -561,13 +737,14 @@ public:
     // Find a successful pop
     (*pmodNumDeq)+=1;
     perItem& p = *current.getLocal();
-    while (!p.lock.try_lock());
+    lockLocal(p);
+    updateDelta(p);
 
     p.sinceLastFix++;
     
     unsigned myID = Runtime::LL::getTID();
 
-    current.getRemote(myID)->pmodAllDeq++;
+    bump(p.stats.data.deqs);
     /*
     if(delta > 0 && myID == 0 && p.sinceLastFix>counter&& p.popsFromSameQ > 4*chunk_size){
       // std::cout<<"1Same queue dequeue"<<std::endl;
@@ -651,7 +828,7 @@ public:
 
     if (C && (retval = C->pop())) {
       p.popsFromSameQ++;
-      p.lock.unlock();
+      unlockLocal(p);
 
       if (sync == true) {
         if (retval.is_initialized()) {
@@ -685,8 +862,9 @@ template<class Indexer, typename Container,
   int chunk_size,
   typename T,
   typename Index,
-  bool Concurrent>
-Statistic* AdaptiveOrderedByIntegerMetric<Indexer, Container, BlockPeriod, BSP, uniformBSP, chunk_size,T, Index, Concurrent>::numberOfPris;
+  bool Concurrent,
+  bool Unmerge>
+Statistic* AdaptiveOrderedByIntegerMetric<Indexer, Container, BlockPeriod, BSP, uniformBSP, chunk_size,T, Index, Concurrent, Unmerge>::numberOfPris;
 template<class Indexer, typename Container,
   int BlockPeriod,
   bool BSP,
@@ -694,8 +872,9 @@ template<class Indexer, typename Container,
   int chunk_size,
   typename T,
   typename Index,
-  bool Concurrent>
-Statistic* AdaptiveOrderedByIntegerMetric<Indexer, Container, BlockPeriod, BSP, uniformBSP, chunk_size,T, Index, Concurrent>::pmodNumDeq;
+  bool Concurrent,
+  bool Unmerge>
+Statistic* AdaptiveOrderedByIntegerMetric<Indexer, Container, BlockPeriod, BSP, uniformBSP, chunk_size,T, Index, Concurrent, Unmerge>::pmodNumDeq;
 } // end namespace WorkList
 } // end namespace Galois
 
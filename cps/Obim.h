@@ -35,6 +35,9 @@
 #include GALOIS_CXX11_STD_HEADER(type_traits)
 #include <limits>
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <iostream>
 
 #ifdef GALOIS_USE_PAPI
@@ -50,6 +53,250 @@ extern "C" {
 namespace Galois {
 namespace WorkList {
 
+//! Where an OBIM bin id sits in OrderedByIntegerMetricIndex, if it fits
+template <typename Index, bool = std::is_integral<Index>::value>
+struct OrderedByIntegerMetricKey {
+  static bool get(Index i, unsigned long& k) {
+    if (i < 0 || (unsigned long long)i >= (1ull << 24))
+      return false;
+    k = i;
+    return true;
+  }
+  static bool below(Index i) { return i < 0; }
+  static Index index(unsigned long k) { return Index(k); }
+};
+
+template <typename Index>
+struct OrderedByIntegerMetricKey<Index, false> {
+  static bool get(Index, unsigned long&) { return false; }
+  static bool below(Index) { return false; }
+  static Index index(unsigned long) { return Index(); }
+};
+
+/**
+ * Shared index of OBIM bins by id, for ids in [0, 2^24). Bins live in pages
+ * of 4096 slots that are allocated the first time one of their ids is used.
+ * A bit per slot says the bin exists, and two summary levels above it (which
+ * words of a page, which pages) let next() skip ranges without bins a word
+ * at a time. The bit does not say the bin holds work: a drained bin keeps it
+ * until take() removes the bin. The worklist takes out drained bins below
+ * every thread's scan, so a scan tries pop() only on the few above that.
+ * Everything is claimed with compare-and-swap, so creating a bin takes no
+ * lock and costs the same however many threads there are. The caller of
+ * take() decides when the bin is safe to free.
+ */
+template <typename CTy>
+class OrderedByIntegerMetricIndex : private boost::noncopyable {
+  static const unsigned PageBits = 12;
+  static const unsigned PageSize = 1u << PageBits;
+  static const unsigned Pages = 4096;
+
+  struct Page {
+    std::atomic<CTy*> bins[PageSize];
+    std::atomic<uint64_t> bits[PageSize / 64];
+    std::atomic<uint64_t> mask; // words of bits that are not zero
+
+    Page() {
+      for (auto& b : bins)
+        b.store(nullptr, std::memory_order_relaxed);
+      for (auto& w : bits)
+        w.store(0, std::memory_order_relaxed);
+      mask.store(0, std::memory_order_relaxed);
+    }
+  };
+
+  std::atomic<Page*> pages[Pages];
+  std::atomic<uint64_t> pageBits[Pages / 64]; // pages that have a bin
+  std::atomic<uint64_t> top; // words of pageBits not zero
+
+  // Loads are seq_cst so that a set racing with clearBit below always sees
+  // the other side's update
+  static void setBit(std::atomic<uint64_t>& w, unsigned b) {
+    uint64_t bit = uint64_t(1) << b;
+    if (!(w.load() & bit))
+      w.fetch_or(bit);
+  }
+
+  //! Clear the bit of k, and its word's bit in mask if the word is now zero
+  static void clearBit(Page* P, unsigned long k) {
+    unsigned w = (k >> 6) & (PageSize / 64 - 1);
+    uint64_t bit = uint64_t(1) << (k & 63);
+    if (P->bits[w].fetch_and(~bit) == bit) {
+      P->mask.fetch_and(~(uint64_t(1) << w));
+      if (P->bits[w].load())
+        setBit(P->mask, w);
+    }
+  }
+
+  //! Bits b and above of a word; none if b is past the end
+  static uint64_t from(uint64_t w, unsigned b) {
+    return b < 64 ? w & (~uint64_t(0) << b) : 0;
+  }
+
+  Page* page(unsigned pg) {
+    Page* P = pages[pg].load(std::memory_order_acquire);
+    if (P)
+      return P;
+    Page* mine = new Page();
+    if (pages[pg].compare_exchange_strong(P, mine))
+      return mine;
+    delete mine;
+    return P;
+  }
+
+public:
+  static const unsigned long Capacity = (unsigned long)Pages << PageBits;
+
+  OrderedByIntegerMetricIndex() {
+    for (auto& P : pages)
+      P.store(nullptr, std::memory_order_relaxed);
+    for (auto& w : pageBits)
+      w.store(0, std::memory_order_relaxed);
+    top.store(0, std::memory_order_relaxed);
+  }
+
+  ~OrderedByIntegerMetricIndex() {
+    for (auto& P : pages) {
+      Page* p = P.load(std::memory_order_relaxed);
+      if (!p)
+        continue;
+      for (auto& b : p->bins)
+        delete b.load(std::memory_order_relaxed);
+      delete p;
+    }
+  }
+
+  CTy* get(unsigned long k) const {
+    Page* P = pages[k >> PageBits].load(std::memory_order_acquire);
+    return P ? P->bins[k & (PageSize - 1)].load(std::memory_order_acquire)
+             : nullptr;
+  }
+
+  //! The bin of k, made with make() if there is none yet. made says
+  //! whether this call's bin was the one kept.
+  template <typename F>
+  CTy* getOrCreate(unsigned long k, F make, bool& made) {
+    unsigned pg = k >> PageBits;
+    Page* P = page(pg);
+    std::atomic<CTy*>& bin = P->bins[k & (PageSize - 1)];
+    CTy* C = bin.load(std::memory_order_acquire);
+    made = false;
+    if (C)
+      return C;
+    CTy* mine = make();
+    if (!bin.compare_exchange_strong(C, mine)) {
+      delete mine;
+      return C;
+    }
+    unsigned w = (k >> 6) & (PageSize / 64 - 1);
+    setBit(P->bits[w], k & 63);
+    setBit(P->mask, w);
+    setBit(pageBits[pg / 64], pg % 64);
+    setBit(top, pg / 64);
+    made = true;
+    return mine;
+  }
+
+  //! Remove the bin of k from the index. Threads that looked it up before
+  //! may still use it.
+  CTy* take(unsigned long k) {
+    Page* P = pages[k >> PageBits].load(std::memory_order_acquire);
+    if (!P)
+      return nullptr;
+    // clear first, so that a bin made after the exchange keeps its bit
+    clearBit(P, k);
+    return P->bins[k & (PageSize - 1)].exchange(nullptr);
+  }
+
+  //! Smallest id at or after k that has a bin, or -1
+  long next(unsigned long k) const {
+    while (k < Capacity) {
+      unsigned pg = k >> PageBits;
+      Page* P = pages[pg].load(std::memory_order_acquire);
+      if (P) {
+        unsigned w = (k >> 6) & (PageSize / 64 - 1);
+        uint64_t m = from(P->bits[w].load(std::memory_order_acquire), k & 63);
+        if (m)
+          return (k & ~63ul) | __builtin_ctzll(m);
+        m = from(P->mask.load(std::memory_order_acquire), w + 1);
+        if (m) {
+          k = ((unsigned long)pg << PageBits) | (__builtin_ctzll(m) << 6);
+          continue;
+        }
+      }
+      // nothing more in this page, find the next page that has a bin
+      if (++pg == Pages)
+        return -1;
+      unsigned q = pg / 64;
+      uint64_t m = from(pageBits[q].load(std::memory_order_acquire), pg % 64);
+      if (!m) {
+        m = from(top.load(std::memory_order_acquire), q + 1);
+        if (!m)
+          return -1;
+        q = __builtin_ctzll(m);
+        m = pageBits[q].load(std::memory_order_acquire);
+        if (!m) {
+          k = (unsigned long)(q + 1) * 64 << PageBits;
+          continue;
+        }
+      }
+      k = (unsigned long)(q * 64 + __builtin_ctzll(m)) << PageBits;
+    }
+    return -1;
+  }
+};
+
+/**
+ * Append-only log that other threads index without a lock. Entries live in
+ * segments that double in size and never move, so an append cannot free
+ * memory a reader is looking at (as growing a std::deque can). One thread
+ * appends at a time; readers only look at entries below a count that was
+ * published with release after the entries were written.
+ */
+template <typename T>
+class OrderedByIntegerMetricLog : private boost::noncopyable {
+  static const unsigned FirstBits = 6;
+  static const unsigned Segments = 64 - FirstBits;
+
+  T* segs[Segments];
+  unsigned long count;
+
+  //! Segment s holds entries [2^(s+FirstBits) - 2^FirstBits, twice that)
+  static unsigned segment(unsigned long i) {
+    return 63 - __builtin_clzll(i + (1UL << FirstBits)) - FirstBits;
+  }
+
+  static unsigned long offset(unsigned long i, unsigned s) {
+    return i + (1UL << FirstBits) - (1UL << (s + FirstBits));
+  }
+
+public:
+  OrderedByIntegerMetricLog() : count(0) {
+    std::fill(segs, segs + Segments, (T*)0);
+  }
+
+  ~OrderedByIntegerMetricLog() {
+    for (unsigned s = 0; s < Segments; ++s)
+      delete[] segs[s];
+  }
+
+  //! Entries appended so far; appender only
+  unsigned long size() const { return count; }
+
+  void push_back(const T& v) {
+    unsigned s = segment(count);
+    if (!segs[s])
+      segs[s] = new T[1UL << (s + FirstBits)];
+    segs[s][offset(count, s)] = v;
+    ++count;
+  }
+
+  T& operator[](unsigned long i) {
+    unsigned s = segment(i);
+    return segs[s][offset(i, s)];
+  }
+};
+
 /**
  * Approximate priority scheduling. Indexer is a default-constructable class
  * whose instances conform to <code>R r = indexer(item)</code> where R is
@@ -108,6 +355,7 @@ private:
 
   typedef typename Container::template rethread<Concurrent>::type CTy;
   typedef Galois::flat_map<Index, CTy*> LMapTy;
+  typedef OrderedByIntegerMetricKey<Index> Key;
   //typedef Galois::flat_map<Index, std::atomic<unsigned int>> CntrMapTy;
   //typedef std::map<Index, CTy*> LMapTy;
 
@@ -119,6 +367,9 @@ private:
     CTy* current;
     unsigned int lastMasterVersion;
     unsigned int numPops;
+    unsigned int lastRetired;
+    std::atomic<unsigned int> retiredSeen;
+    std::atomic<unsigned long> scanFloor; // bin id of scanBase, for recycle
 
     int pd_counter = 0;
     unsigned int latest_index = 0;
@@ -126,7 +377,7 @@ private:
     perItem() :
       curIndex(std::numeric_limits<Index>::min()),
       scanStart(std::numeric_limits<Index>::min()),
-      current(0), lastMasterVersion(0), numPops(0) { }
+      current(0), lastMasterVersion(0), numPops(0), lastRetired(0), retiredSeen(0), scanFloor(0) { }
   };
 
   typedef std::deque<std::pair<Index, CTy*> > MasterLog;
@@ -137,6 +388,19 @@ private:
   Runtime::LL::PaddedLock<Concurrent> masterLock;
   Galois::Timer clock;
   MasterLog masterLog;
+  // Bins whose id fits here skip masterLog and the per-thread maps
+  OrderedByIntegerMetricIndex<CTy> bins;
+
+  // Bins below every thread's scanBase are drained, so thread 0 takes them
+  // out of the index and appends them to retired. Each thread then moves out
+  // what only it can pop from them and raises retiredSeen; once all have,
+  // the bin goes to freeBins for the next new index to reuse.
+  OrderedByIntegerMetricLog<CTy*> retired;
+  std::atomic<unsigned int> retiredVersion;
+  unsigned int reclaimed; // thread 0 only
+  std::atomic<unsigned long> sweptTo;
+  Runtime::LL::PaddedLock<Concurrent> freeLock;
+  std::vector<CTy*> freeBins;
 
 
   //counters per priority
@@ -184,6 +448,10 @@ private:
   GALOIS_ATTRIBUTE_NOINLINE
   Galois::optional<T> slowPop(perItem& p) {
     //Failed, find minimum bin
+    p.scanFloor.store(floorOf(scanBase(p)), std::memory_order_relaxed);
+    retireLocal(p);
+    if (Runtime::LL::getTID() == 0)
+      recycle(p);
     updateLocal(p);
     unsigned myID = Runtime::LL::getTID();
     bool localLeader = Runtime::LL::isPackageLeaderForSelf(myID);
@@ -199,18 +467,127 @@ private:
       }
     }
 
-    for (auto ii = p.local.lower_bound(msS), ee = p.local.end(); ii != ee; ++ii) {
-      Galois::optional<T> retval;
-      if ((retval = ii->second->pop())) {
-        p.current = ii->second;
-        p.curIndex = ii->first;
-        p.scanStart = ii->first;
+    //the map only holds the bins below and above the index
+    Galois::optional<T> retval;
+    auto ii = p.local.lower_bound(msS), ee = p.local.end();
+    for (; ii != ee && Key::below(ii->first); ++ii)
+      if ((retval = popBin(p, ii->first, ii->second)))
+        return retval;
+
+    unsigned long k = 0;
+    long n = Key::below(msS) || Key::get(msS, k) ? bins.next(k) : -1;
+    for (; n >= 0; n = bins.next(n + 1)) {
+      CTy* C = bins.get(n);
+      if (C && (retval = popBin(p, Key::index(n), C)))
         return retval;
-      }
     }
+
+    for (; ii != ee; ++ii)
+      if ((retval = popBin(p, ii->first, ii->second)))
+        return retval;
     return Galois::optional<value_type>();
   }
 
+  Galois::optional<T> popBin(perItem& p, Index i, CTy* C) {
+    Galois::optional<T> retval = C->pop();
+    if (retval) {
+      p.current = C;
+      p.curIndex = i;
+      p.scanStart = i;
+    }
+    return retval;
+  }
+
+  //! Lowest bin this thread may still want. Its last scan found the bins
+  //! below empty, and its pushes below have lowered it since. That is
+  //! scanStart, or without back-scan prevention the bin it pops from.
+  Index scanBase(const perItem& p) const {
+    return BSP ? p.scanStart : p.curIndex;
+  }
+
+  //! Smallest bin id at or after i
+  unsigned long floorOf(Index i) const {
+    unsigned long k = 0;
+    if (!Key::below(i) && !Key::get(i, k))
+      k = bins.Capacity;
+    return k;
+  }
+
+  CTy* makeBin(Index i) {
+    CTy* C = nullptr;
+    if (freeLock.try_lock()) {
+      if (!freeBins.empty()) {
+        C = freeBins.back();
+        freeBins.pop_back();
+      }
+      freeLock.unlock();
+    }
+    return C ? C : new CTy(i);
+  }
+
+  //! Push back whatever this thread can still pop from a retired bin
+  void moveOut(CTy* C) {
+    std::vector<T> items;
+    Galois::optional<T> retval;
+    while ((retval = C->pop()))
+      items.push_back(*retval);
+    for (auto& val : items)
+      push(val);
+  }
+
+  //! Let go of the bins thread 0 retired since this thread last looked
+  void retireLocal(perItem& p) {
+    unsigned int v = retiredVersion.load(std::memory_order_acquire);
+    if (p.lastRetired == v)
+      return;
+    for (; p.lastRetired < v; ++p.lastRetired) {
+      CTy* C = retired[p.lastRetired];
+      if (p.current == C)
+        p.current = 0;
+      moveOut(C);
+    }
+    p.retiredSeen.store(v, std::memory_order_release);
+  }
+
+  //! Thread 0 only: retire the bins below every scanBase and recycle the
+  //! ones all threads have let go of
+  void recycle(perItem& p) {
+    unsigned long k = p.scanFloor.load(std::memory_order_relaxed);
+    unsigned long from = sweptTo.load(std::memory_order_relaxed);
+    for (unsigned i = 0; i < Runtime::activeThreads; ++i)
+      k = std::min(k, current.getRemote(i)->scanFloor.load(std::memory_order_relaxed));
+    if (k > from) {
+      std::vector<CTy*> gone;
+      for (long n = bins.next(from); n >= 0 && (unsigned long)n < k; n = bins.next(n + 1))
+        if (CTy* C = bins.take(n))
+          gone.push_back(C);
+      // a late push below low may have lowered it meanwhile; keep that
+      sweptTo.compare_exchange_strong(from, k);
+      if (!gone.empty()) {
+        for (auto ii = gone.begin(), ei = gone.end(); ii != ei; ++ii)
+          retired.push_back(*ii);
+        retiredVersion.store(retired.size(), std::memory_order_release);
+        retireLocal(p);
+      }
+    }
+
+    unsigned int done = retiredVersion.load(std::memory_order_relaxed);
+    for (unsigned i = 0; i < Runtime::activeThreads; ++i)
+      done = std::min(done, current.getRemote(i)->retiredSeen.load(std::memory_order_acquire));
+    if (done == reclaimed)
+      return;
+    std::vector<CTy*> ready;
+    for (; reclaimed < done; ++reclaimed) {
+      CTy* C = retired[reclaimed];
+      // every thread has moved out its part, this only catches stragglers
+      moveOut(C);
+      ready.push_back(C);
+    }
+    freeLock.lock();
+    freeBins.insert(freeBins.end(), ready.begin(), ready.end());
+    freeLock.unlock();
+  }
+
   GALOIS_ATTRIBUTE_NOINLINE
   CTy* slowUpdateLocalOrCreate(perItem& p, Index i) {
     //update local until we find it or we get the write lock
@@ -238,6 +615,19 @@ private:
   inline CTy* updateLocalOrCreate(perItem& p, Index i) {
     //Try local then try update then find again or else create and update the master log
     CTy* lC;
+    unsigned long k;
+    if (Key::get(i, k)) {
+      bool made;
+      lC = bins.getOrCreate(k, [this, i] { return makeBin(i); }, made);
+      if (made) {
+        (*numberOfPris)+=1;
+        // a bin below the swept range must be swept again
+        unsigned long s = sweptTo.load(std::memory_order_relaxed);
+        while (k < s && !sweptTo.compare_exchange_weak(s, k))
+          ;
+      }
+      return lC;
+    }
     if ((lC = p.local[i]))
       return lC;
     //slowpath
@@ -271,7 +661,7 @@ public:
   static Galois::Statistic* deqEventNum4;
 #endif
 #endif
-  OrderedByIntegerMetric(const Indexer& x = Indexer()): heap(sizeof(CTy)), masterVersion(0), indexer(x) {
+  OrderedByIntegerMetric(const Indexer& x = Indexer()): retiredVersion(0), reclaimed(0), sweptTo(0), heap(sizeof(CTy)), masterVersion(0), indexer(x) {
     clock.start();
     if(numberOfPris == 0){
       numberOfPris = new Galois::Statistic("numberOfPris");
@@ -418,6 +808,10 @@ public:
       lC->~CTy();
       heap.deallocate(lC);
     }
+    for (unsigned long i = reclaimed; i < retired.size(); ++i)
+      delete retired[i];
+    for (auto ii = freeBins.begin(), ei = freeBins.end(); ii != ei; ++ii)
+      delete *ii;
 
     if(numberOfPris!=0){
       std::cout<<"Number of Pris statistics dealloced\n";
@@ -22,14 +22,20 @@
 
 #include "galois/FlatMap.h"
 #include "galois/runtime/Substrate.h"
+#include "galois/substrate/NumaMem.h"
 #include "galois/substrate/PerThreadStorage.h"
 //#include "galois/substrate/Termination.h"
 #include "galois/worklists/Chunk.h"
 #include "galois/worklists/WorkListHelpers.h"
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <deque>
+#include <iostream>
 #include <limits>
 #include <type_traits>
+#include <vector>
 
 namespace galois {
 namespace worklists {
@@ -106,6 +112,246 @@ struct OrderedByIntegerMetricComparator<Index, true> {
       : identity(std::numeric_limits<Index>::max()) {}
 };
 
+//! Where an OBIM bin id sits in OrderedByIntegerMetricIndex, if it fits
+template <typename Index, bool = std::is_integral<Index>::value>
+struct OrderedByIntegerMetricKey {
+  static bool get(Index i, unsigned long& k) {
+    if (i < 0 || (unsigned long long)i >= (1ull << 24))
+      return false;
+    k = i;
+    return true;
+  }
+  static bool below(Index i) { return i < 0; }
+  static Index index(unsigned long k) { return Index(k); }
+};
+
+template <typename Index>
+struct OrderedByIntegerMetricKey<Index, false> {
+  static bool get(Index, unsigned long&) { return false; }
+  static bool below(Index) { return false; }
+  static Index index(unsigned long) { return Index(); }
+};
+
+/**
+ * Shared index of OBIM bins by id, for ids in [0, 2^24). Bins live in pages
+ * of 4096 slots that are allocated the first time one of their ids is used.
+ * A bit per slot says the bin exists, and two summary levels above it (which
+ * words of a page, which pages) let next() skip ranges without bins a word
+ * at a time. The bit does not say the bin holds work: a drained bin keeps it
+ * until take() removes the bin. The worklist takes out drained bins below
+ * every thread's scan, so a scan tries pop() only on the few above that.
+ * Everything is claimed with compare-and-swap, so creating a bin takes no
+ * lock and costs the same however many threads there are. The caller of
+ * take() decides when the bin is safe to free.
+ */
+template <typename CTy>
+class OrderedByIntegerMetricIndex : private boost::noncopyable {
+  static const unsigned PageBits = 12;
+  static const unsigned PageSize = 1u << PageBits;
+  static const unsigned Pages    = 4096;
+
+  struct Page {
+    std::atomic<CTy*> bins[PageSize];
+    std::atomic<uint64_t> bits[PageSize / 64];
+    std::atomic<uint64_t> mask; // words of bits that are not zero
+
+    Page() {
+      for (auto& b : bins)
+        b.store(nullptr, std::memory_order_relaxed);
+      for (auto& w : bits)
+        w.store(0, std::memory_order_relaxed);
+      mask.store(0, std::memory_order_relaxed);
+    }
+  };
+
+  std::atomic<Page*> pages[Pages];
+  std::atomic<uint64_t> pageBits[Pages / 64]; // pages that have a bin
+  std::atomic<uint64_t> top;                  // words of pageBits not zero
+
+  // Loads are seq_cst so that a set racing with clearBit below always sees
+  // the other side's update
+  static void setBit(std::atomic<uint64_t>& w, unsigned b) {
+    uint64_t bit = uint64_t(1) << b;
+    if (!(w.load() & bit))
+      w.fetch_or(bit);
+  }
+
+  //! Clear the bit of k, and its word's bit in mask if the word is now zero
+  static void clearBit(Page* P, unsigned long k) {
+    unsigned w   = (k >> 6) & (PageSize / 64 - 1);
+    uint64_t bit = uint64_t(1) << (k & 63);
+    if (P->bits[w].fetch_and(~bit) == bit) {
+      P->mask.fetch_and(~(uint64_t(1) << w));
+      if (P->bits[w].load())
+        setBit(P->mask, w);
+    }
+  }
+
+  //! Bits b and above of a word; none if b is past the end
+  static uint64_t from(uint64_t w, unsigned b) {
+    return b < 64 ? w & (~uint64_t(0) << b) : 0;
+  }
+
+  Page* page(unsigned pg) {
+    Page* P = pages[pg].load(std::memory_order_acquire);
+    if (P)
+      return P;
+    Page* mine = new Page();
+    if (pages[pg].compare_exchange_strong(P, mine))
+      return mine;
+    delete mine;
+    return P;
+  }
+
+public:
+  static const unsigned long Capacity = (unsigned long)Pages << PageBits;
+
+  OrderedByIntegerMetricIndex() {
+    for (auto& P : pages)
+      P.store(nullptr, std::memory_order_relaxed);
+    for (auto& w : pageBits)
+      w.store(0, std::memory_order_relaxed);
+    top.store(0, std::memory_order_relaxed);
+  }
+
+  ~OrderedByIntegerMetricIndex() {
+    for (auto& P : pages) {
+      Page* p = P.load(std::memory_order_relaxed);
+      if (!p)
+        continue;
+      for (auto& b : p->bins)
+        delete b.load(std::memory_order_relaxed);
+      delete p;
+    }
+  }
+
+  CTy* get(unsigned long k) const {
+    Page* P = pages[k >> PageBits].load(std::memory_order_acquire);
+    return P ? P->bins[k & (PageSize - 1)].load(std::memory_order_acquire)
+             : nullptr;
+  }
+
+  //! The bin of k, made with make() if there is none yet. made says
+  //! whether this call's bin was the one kept.
+  template <typename F>
+  CTy* getOrCreate(unsigned long k, F make, bool& made) {
+    unsigned pg            = k >> PageBits;
+    Page* P                = page(pg);
+    std::atomic<CTy*>& bin = P->bins[k & (PageSize - 1)];
+    CTy* C                 = bin.load(std::memory_order_acquire);
+    made                   = false;
+    if (C)
+      return C;
+    CTy* mine = make();
+    if (!bin.compare_exchange_strong(C, mine)) {
+      delete mine;
+      return C;
+    }
+    unsigned w = (k >> 6) & (PageSize / 64 - 1);
+    setBit(P->bits[w], k & 63);
+    setBit(P->mask, w);
+    setBit(pageBits[pg / 64], pg % 64);
+    setBit(top, pg / 64);
+    made = true;
+    return mine;
+  }
+
+  //! Remove the bin of k from the index. Threads that looked it up before
+  //! may still use it.
+  CTy* take(unsigned long k) {
+    Page* P = pages[k >> PageBits].load(std::memory_order_acquire);
+    if (!P)
+      return nullptr;
+    // clear first, so that a bin made after the exchange keeps its bit
+    clearBit(P, k);
+    return P->bins[k & (PageSize - 1)].exchange(nullptr);
+  }
+
+  //! Smallest id at or after k that has a bin, or -1
+  long next(unsigned long k) const {
+    while (k < Capacity) {
+      unsigned pg = k >> PageBits;
+      Page* P     = pages[pg].load(std::memory_order_acquire);
+      if (P) {
+        unsigned w = (k >> 6) & (PageSize / 64 - 1);
+        uint64_t m = from(P->bits[w].load(std::memory_order_acquire), k & 63);
+        if (m)
+          return (k & ~63ul) | __builtin_ctzll(m);
+        m = from(P->mask.load(std::memory_order_acquire), w + 1);
+        if (m) {
+          k = ((unsigned long)pg << PageBits) | (__builtin_ctzll(m) << 6);
+          continue;
+        }
+      }
+      // nothing more in this page, find the next page that has a bin
+      if (++pg == Pages)
+        return -1;
+      unsigned q = pg / 64;
+      uint64_t m = from(pageBits[q].load(std::memory_order_acquire), pg % 64);
+      if (!m) {
+        m = from(top.load(std::memory_order_acquire), q + 1);
+        if (!m)
+          return -1;
+        q = __builtin_ctzll(m);
+        m = pageBits[q].load(std::memory_order_acquire);
+        if (!m) {
+          k = (unsigned long)(q + 1) * 64 << PageBits;
+          continue;
+        }
+      }
+      k = (unsigned long)(q * 64 + __builtin_ctzll(m)) << PageBits;
+    }
+    return -1;
+  }
+};
+
+/**
+ * Append-only log that other threads index without a lock. Entries live in
+ * segments that double in size and never move, so an append cannot free
+ * memory a reader is looking at (as growing a std::deque can). One thread
+ * appends at a time; readers only look at entries below a count that was
+ * published with release after the entries were written.
+ */
+template <typename T>
+class OrderedByIntegerMetricLog : private boost::noncopyable {
+  static const unsigned FirstBits = 6;
+  static const unsigned Segments  = 64 - FirstBits;
+
+  T* segs[Segments] = {};
+  unsigned long count = 0;
+
+  //! Segment s holds entries [2^(s+FirstBits) - 2^FirstBits, twice that)
+  static unsigned segment(unsigned long i) {
+    return 63 - __builtin_clzll(i + (1ul << FirstBits)) - FirstBits;
+  }
+
+  static unsigned long offset(unsigned long i, unsigned s) {
+    return i + (1ul << FirstBits) - (1ul << (s + FirstBits));
+  }
+
+public:
+  ~OrderedByIntegerMetricLog() {
+    for (T* seg : segs)
+      delete[] seg;
+  }
+
+  //! Entries appended so far; appender only
+  unsigned long size() const { return count; }
+
+  void push_back(const T& v) {
+    unsigned s = segment(count);
+    if (!segs[s])
+      segs[s] = new T[1ul << (s + FirstBits)];
+    segs[s][offset(count, s)] = v;
+    ++count;
+  }
+
+  T& operator[](unsigned long i) {
+    unsigned s = segment(i);
+    return segs[s][offset(i, s)];
+  }
+};
+
 } // namespace internal
 
 /**
@@ -227,6 +473,11 @@ private:
   typedef internal::OrderedByIntegerMetricComparator<Index, UseDescending>
       Comparator;
   typedef typename Comparator::template with_local_map<CTy*>::type LMapTy;
+  typedef internal::OrderedByIntegerMetricKey<Index> Key;
+
+  // Bins whose id fits the index are found there by every thread, and only
+  // the others go through masterLog and the per-thread maps
+  static const bool UseIndex = !UseDescending && !UseBarrier;
   
   bool sync;
   int pd;
@@ -243,10 +494,14 @@ private:
     CTy* current;
     unsigned int lastMasterVersion;
     unsigned int numPops;
+    unsigned int lastRetired;
+    std::atomic<unsigned int> retiredSeen;
+    std::atomic<unsigned long> scanFloor; // bin id of scanBase, for recycle
 
     ThreadData(Index initial)
         : curIndex(initial), scanStart(initial), current(0),
-          lastMasterVersion(0), numPops(0) {}
+          lastMasterVersion(0), numPops(0), lastRetired(0), retiredSeen(0),
+          scanFloor(0) {}
   };
 
   typedef std::deque<std::pair<Index, CTy*>> MasterLog;
@@ -256,6 +511,19 @@ private:
   substrate::PerThreadStorage<ThreadData> data;
   substrate::PaddedLock<Concurrent> masterLock;
   MasterLog masterLog;
+  internal::OrderedByIntegerMetricIndex<CTy> bins;
+
+  // Bins below every thread's scanBase are drained, so thread 0 takes them
+  // out of the index and appends them to retired. Each thread then moves out
+  // what only it can pop from them (its partly filled chunks) and raises
+  // retiredSeen. A bin that every thread has seen retired is unreachable and
+  // goes to freeBins, to be reused for the next new index.
+  internal::OrderedByIntegerMetricLog<CTy*> retired;
+  std::atomic<unsigned int> retiredVersion;
+  unsigned int reclaimed; // thread 0 only
+  std::atomic<unsigned long> sweptTo;
+  substrate::PaddedLock<Concurrent> freeLock;
+  std::vector<CTy*> freeBins;
 
   std::atomic<unsigned int> masterVersion;
   Indexer indexer;
@@ -285,6 +553,12 @@ private:
     bool localLeader = substrate::ThreadPool::isLeader();
     Index msS        = this->identity;
 
+    if (UseIndex)
+      p.scanFloor.store(floorOf(scanBase(p)), std::memory_order_relaxed);
+    retireLocal(p);
+    if (UseIndex && substrate::ThreadPool::getTID() == 0)
+      recycle(p);
+
     updateLocal(p);
 
     if (BSP && !UseMonotonic) {
@@ -302,6 +576,9 @@ private:
       }
     }
 
+    if (UseIndex)
+      return popIndexed(p, msS);
+
     for (auto ii = p.local.lower_bound(msS), ei = p.local.end(); ii != ei;
          ++ii) {
       galois::optional<T> item;
@@ -316,6 +593,131 @@ private:
     return galois::optional<value_type>();
   }
 
+  galois::optional<T> popBin(ThreadData& p, Index i, CTy* C) {
+    galois::optional<T> item = C->pop();
+    if (item) {
+      p.current   = C;
+      p.curIndex  = i;
+      p.scanStart = i;
+    }
+    return item;
+  }
+
+  //! slowPop with the index: the map only holds bins below and above it
+  galois::optional<T> popIndexed(ThreadData& p, Index msS) {
+    galois::optional<T> item;
+    auto ii = p.local.lower_bound(msS), ei = p.local.end();
+    for (; ii != ei && Key::below(ii->first); ++ii)
+      if ((item = popBin(p, ii->first, ii->second)))
+        return item;
+
+    unsigned long k = 0;
+    long n = Key::below(msS) || Key::get(msS, k) ? bins.next(k) : -1;
+    for (; n >= 0; n = bins.next(n + 1)) {
+      CTy* C = bins.get(n);
+      if (C && (item = popBin(p, Key::index(n), C)))
+        return item;
+    }
+
+    for (; ii != ei; ++ii)
+      if ((item = popBin(p, ii->first, ii->second)))
+        return item;
+    return item;
+  }
+
+  //! Lowest bin this thread may still want. Its last scan found the bins
+  //! below empty, and its pushes below have lowered it since. That is
+  //! scanStart, or without back-scan prevention the bin it pops from.
+  Index scanBase(const ThreadData& p) const {
+    return BSP ? p.scanStart : p.curIndex;
+  }
+
+  //! Smallest bin id at or after i
+  unsigned long floorOf(Index i) const {
+    unsigned long k = 0;
+    if (!Key::below(i) && !Key::get(i, k))
+      k = bins.Capacity;
+    return k;
+  }
+
+  CTy* makeBin() {
+    CTy* C = nullptr;
+    if (freeLock.try_lock()) {
+      if (!freeBins.empty()) {
+        C = freeBins.back();
+        freeBins.pop_back();
+      }
+      freeLock.unlock();
+    }
+    return C ? C : new CTy();
+  }
+
+  //! Push back whatever this thread can still pop from a retired bin
+  void moveOut(CTy* C) {
+    std::vector<value_type> items;
+    galois::optional<value_type> item;
+    while ((item = C->pop()))
+      items.push_back(*item);
+    for (auto& val : items)
+      push(val);
+  }
+
+  //! Let go of the bins thread 0 retired since this thread last looked
+  void retireLocal(ThreadData& p) {
+    unsigned int v = retiredVersion.load(std::memory_order_acquire);
+    if (p.lastRetired == v)
+      return;
+    for (; p.lastRetired < v; ++p.lastRetired) {
+      CTy* C = retired[p.lastRetired];
+      if (p.current == C)
+        p.current = nullptr;
+      moveOut(C);
+    }
+    p.retiredSeen.store(v, std::memory_order_release);
+  }
+
+  //! Thread 0 only: retire the bins below every scanBase and recycle the
+  //! ones all threads have let go of
+  void recycle(ThreadData& p) {
+    unsigned long k    = p.scanFloor.load(std::memory_order_relaxed);
+    unsigned long from = sweptTo.load(std::memory_order_relaxed);
+    for (unsigned i = 0; i < runtime::activeThreads; ++i)
+      k = std::min(k, data.getRemote(i)->scanFloor.load(
+                          std::memory_order_relaxed));
+    if (k > from) {
+      std::vector<CTy*> gone;
+      for (long n = bins.next(from); n >= 0 && (unsigned long)n < k;
+           n = bins.next(n + 1))
+        if (CTy* C = bins.take(n))
+          gone.push_back(C);
+      // a late push below low may have lowered it meanwhile; keep that
+      sweptTo.compare_exchange_strong(from, k);
+      if (!gone.empty()) {
+        for (CTy* C : gone)
+          retired.push_back(C);
+        retiredVersion.store(retired.size(), std::memory_order_release);
+        retireLocal(p);
+      }
+    }
+
+    unsigned int done = retiredVersion.load(std::memory_order_relaxed);
+    for (unsigned i = 0; i < runtime::activeThreads; ++i)
+      done = std::min(done, data.getRemote(i)->retiredSeen.load(
+                                std::memory_order_acquire));
+    if (done == reclaimed)
+      return;
+    std::vector<CTy*> ready;
+    for (; reclaimed < done; ++reclaimed) {
+      CTy* C = retired[reclaimed];
+      // every thread has moved out its part, this only catches stragglers
+      moveOut(C);
+      ready.push_back(C);
+    }
+    freeLock.lock();
+    freeBins.insert(freeBins.end(), ready.begin(), ready.end());
+    freeLock.unlock();
+  }
+
   GALOIS_ATTRIBUTE_NOINLINE
   CTy* slowUpdateLocalOrCreate(ThreadData& p, Index i) {
     // update local until we find it or we get the write lock
@@ -342,6 +744,16 @@ private:
     // Try local then try update then find again or else create and update the
     // master log
     CTy* C;
+    unsigned long k;
+    if (UseIndex && Key::get(i, k)) {
+      bool made;
+      C = bins.getOrCreate(k, [this] { return makeBin(); }, made);
+      // a bin below the swept range must be swept again
+      unsigned long s = sweptTo.load(std::memory_order_relaxed);
+      while (made && k < s && !sweptTo.compare_exchange_weak(s, k))
+        ;
+      return C;
+    }
     if ((C = p.local[i]))
       return C;
     // slowpath
@@ -350,7 +762,8 @@ private:
 
 public:
   OrderedByIntegerMetric(const Indexer& x = Indexer())
-      : data(this->identity), masterVersion(0), indexer(x) {}
+      : data(this->identity), retiredVersion(0), reclaimed(0), sweptTo(0),
+        masterVersion(0), indexer(x) {}
 
   ~OrderedByIntegerMetric() {
     // Deallocate in LIFO order to give opportunity for simple garbage
@@ -358,6 +771,10 @@ public:
     for (auto ii = masterLog.rbegin(), ei = masterLog.rend(); ii != ei; ++ii) {
       delete ii->second;
     }
+    for (unsigned long i = reclaimed; i < retired.size(); ++i)
+      delete retired[i];
+    for (CTy* C : freeBins)
+      delete C;
   }
 
   void push(const value_type& val) {
@@ -507,8 +924,259 @@ public:
 GALOIS_WLCOMPILECHECK(OrderedByIntegerMetric)
 
 /* minn */
+
+//! Slots in the ring that carries a worker's pushes to its helper
+#define MINNOW_RING_SIZE 4096
+//! Slots in the ring that carries a helper's pops back to the worker
+#define MINNOW_DEQUEUE_SIZE 64
+//! Tasks a helper keeps ready in each worker's dequeue ring
+#define MINNOW_PREFETCH 8
+//! Tasks a helper moves per enqueue ring access
+#define MINNOW_BATCH 32
+
+static_assert(MINNOW_PREFETCH <= MINNOW_DEQUEUE_SIZE,
+              "a refill must fit in the dequeue ring");
+
+/**
+ * Which threads of a Minnow loop are helpers and which workers each one
+ * serves.
+ *
+ *  - LAST: the last threads are helpers. Workers are split into contiguous
+ *    groups whose sizes differ by at most one.
+ *  - SOCKET: helpers are spread over the sockets in proportion to their
+ *    threads, and each serves workers on its own socket.
+ *  - SMT: the threads past the last physical core are helpers, each serving
+ *    the worker on the other hardware context of its core (Galois numbers
+ *    second contexts after all first ones). helpers is ignored. Falls back
+ *    to LAST when the loop has no such threads.
+ *  - MAP: map[t] is -1 if thread t is a helper, otherwise the helper that
+ *    serves it.
+ *
+ * helpers == 0 takes one helper per workers_per_helper workers, so the
+ * helper count follows the thread count. A worker without a helper (e.g. a
+ * loop on one thread, or map[t] == t) runs its buckets itself.
+ */
+struct MinnowConfig {
+  enum Placement { LAST, SOCKET, SMT, MAP };
+
+  unsigned helpers;
+  Placement placement;
+  unsigned workers_per_helper;
+  std::vector<int> map;
+
+  MinnowConfig(unsigned helpers = 0, Placement placement = LAST,
+               unsigned workers_per_helper = 4, std::vector<int> map = {})
+      : helpers(helpers), placement(placement),
+        workers_per_helper(workers_per_helper), map(std::move(map)) {}
+};
+
 namespace internal {
 
+/**
+ * Thread roles for a Minnow loop on the given number of threads. Entry t is
+ * -1 if thread t is a helper, otherwise the thread that runs the buckets of
+ * worker t: its helper, or t itself. Every worker is covered, and a helper
+ * left without workers becomes a worker serving itself.
+ */
+inline std::vector<int> minnowPlacement(const MinnowConfig& cfg,
+                                        unsigned threads) {
+  std::vector<int> helperOf(threads);
+  for (unsigned t = 0; t < threads; ++t)
+    helperOf[t] = t;
+
+  unsigned helpers =
+      cfg.helpers ? cfg.helpers : threads / (cfg.workers_per_helper + 1);
+  helpers = std::min(helpers, threads / 2);
+
+  // The last h of tids become helpers, the rest are split among them
+  auto assign = [&](const std::vector<unsigned>& tids, unsigned h) {
+    if (!h)
+      return;
+    unsigned workers = tids.size() - h;
+    for (unsigned k = 0; k < h; ++k)
+      helperOf[tids[workers + k]] = -1;
+    for (unsigned w = 0; w < workers; ++w)
+      helperOf[tids[w]] = tids[workers + w * h / workers];
+  };
+
+  auto& tp = substrate::getThreadPool();
+  MinnowConfig::Placement placement = cfg.placement;
+  if (placement == MinnowConfig::SMT && threads <= tp.getMaxCores())
+    placement = MinnowConfig::LAST;
+
+  switch (placement) {
+  case MinnowConfig::LAST: {
+    std::vector<unsigned> all(threads);
+    for (unsigned t = 0; t < threads; ++t)
+      all[t] = t;
+    assign(all, helpers);
+    break;
+  }
+  case MinnowConfig::SOCKET: {
+    std::vector<std::vector<unsigned>> bySocket;
+    for (unsigned t = 0; t < threads; ++t) {
+      unsigned s = tp.getSocket(t);
+      if (s >= bySocket.size())
+        bySocket.resize(s + 1);
+      bySocket[s].push_back(t);
+    }
+    // Each helper goes where it leaves the fewest workers per helper
+    std::vector<unsigned> share(bySocket.size());
+    for (unsigned k = 0; k < helpers; ++k) {
+      int best      = -1;
+      double bestWs = 0;
+      for (unsigned s = 0; s < bySocket.size(); ++s) {
+        unsigned n = bySocket[s].size();
+        if (n < 2 * (share[s] + 1))
+          continue;
+        double ws = double(n - share[s]) / (share[s] + 1);
+        if (ws > bestWs) {
+          best   = s;
+          bestWs = ws;
+        }
+      }
+      if (best < 0)
+        break;
+      ++share[best];
+    }
+    for (unsigned s = 0; s < bySocket.size(); ++s)
+      assign(bySocket[s], share[s]);
+    break;
+  }
+  case MinnowConfig::SMT: {
+    unsigned cores = tp.getMaxCores();
+    for (unsigned t = cores; t < threads; ++t) {
+      helperOf[t]         = -1;
+      helperOf[t - cores] = t;
+    }
+    break;
+  }
+  case MinnowConfig::MAP:
+    for (unsigned t = 0; t < threads; ++t) {
+      int m = t < cfg.map.size() ? cfg.map[t] : -2;
+      if (m != -1 && m != (int)t &&
+          (m < 0 || m >= (int)threads || m >= (int)cfg.map.size() ||
+           cfg.map[m] != -1)) {
+        std::cerr << "invalid Minnow helper map entry for thread " << t
+                  << "\n";
+        abort();
+      }
+      helperOf[t] = m;
+    }
+    break;
+  }
+
+  std::vector<unsigned> served(threads);
+  for (unsigned t = 0; t < threads; ++t)
+    if (helperOf[t] >= 0 && helperOf[t] != (int)t)
+      ++served[helperOf[t]];
+  for (unsigned t = 0; t < threads; ++t)
+    if (helperOf[t] == -1 && !served[t])
+      helperOf[t] = t;
+  return helperOf;
+}
+
+/**
+ * Bounded single-producer/single-consumer ring between a Minnow worker and
+ * its helper. Each side owns one index on its own cache line and keeps a
+ * private copy of the other side's index, which it refreshes only when that
+ * copy shows too little room (producer) or too few items (consumer), so the
+ * common case touches no shared line but the slots themselves. Bulk operations publish a whole
+ * batch with one release store.
+ *
+ * The slots are allocated by allocate(), which the worker calls so that they
+ * live on the worker's NUMA node.
+ */
+template <typename T, unsigned Size>
+class MinnowRing : private boost::noncopyable {
+  static_assert((Size & (Size - 1)) == 0, "ring size must be a power of two");
+
+  struct Side {
+    std::atomic<unsigned long> pos;
+    unsigned long peer; // last seen position of the other side
+  };
+
+  substrate::CacheLineStorage<Side> prod;
+  substrate::CacheLineStorage<Side> cons;
+  substrate::LAptr mem;
+  T* slots = nullptr;
+
+public:
+  MinnowRing() {
+    prod.data.pos.store(0, std::memory_order_relaxed);
+    prod.data.peer = 0;
+    cons.data.pos.store(0, std::memory_order_relaxed);
+    cons.data.peer = 0;
+  }
+
+  ~MinnowRing() {
+    if (!slots)
+      return;
+    for (unsigned i = 0; i < Size; ++i)
+      slots[i].~T();
+  }
+
+  void allocate() {
+    mem   = substrate::largeMallocLocal(Size * sizeof(T));
+    slots = static_cast<T*>(mem.get());
+    for (unsigned i = 0; i < Size; ++i)
+      new (&slots[i]) T();
+  }
+
+  //! Producer only. Appends as much of [b, e) as fits and returns the
+  //! position of the first item left over.
+  template <typename Iter>
+  Iter push_bulk(Iter b, Iter e) {
+    unsigned long t    = prod.data.pos.load(std::memory_order_relaxed);
+    unsigned long room = Size - (t - prod.data.peer);
+    unsigned long n    = 0;
+    for (; b != e; ++b, ++n) {
+      if (n == room) {
+        // the cached index only ever undercounts the room; look again
+        // before leaving anything over
+        prod.data.peer = cons.data.pos.load(std::memory_order_acquire);
+        if ((room = Size - (t - prod.data.peer)) == n)
+          break;
+      }
+      slots[(t + n) & (Size - 1)] = *b;
+    }
+    if (n)
+      prod.data.pos.store(t + n, std::memory_order_release);
+    return b;
+  }
+
+  //! Producer only. Returns false if the ring is full.
+  bool try_push(const T& val) { return push_bulk(&val, &val + 1) != &val; }
+
+  //! Consumer only. Moves up to max items to out and returns how many.
+  unsigned pop_bulk(T* out, unsigned max) {
+    unsigned long h     = cons.data.pos.load(std::memory_order_relaxed);
+    unsigned long avail = cons.data.peer - h;
+    if (avail < max) {
+      cons.data.peer = prod.data.pos.load(std::memory_order_acquire);
+      avail          = cons.data.peer - h;
+    }
+    unsigned n = std::min<unsigned long>(avail, max);
+    for (unsigned k = 0; k < n; ++k)
+      out[k] = slots[(h + k) & (Size - 1)];
+    if (n)
+      cons.data.pos.store(h + n, std::memory_order_release);
+    return n;
+  }
+
+  //! Consumer only.
+  bool try_pop(T& val) { return pop_bulk(&val, 1); }
+
+  //! Items in the ring. Never below the true count when called by the
+  //! producer, never above it when called by the consumer.
+  unsigned long size() const {
+    unsigned long h = cons.data.pos.load(std::memory_order_acquire);
+    return prod.data.pos.load(std::memory_order_acquire) - h;
+  }
+
+  bool empty() const { return size() == 0; }
+};
+
 template <typename T, typename Index, bool UseBarrier>
 class OrderedByIntegerMetricMinnData {
 protected:
@@ -708,13 +1376,23 @@ private:
   struct ThreadData
       : public internal::OrderedByIntegerMetricMinnData<T, Index,
                                                     UseBarrier>::ThreadData {
-    queue<T> minnow_enqueue;
-    queue<galois::optional<T>> minnow_dequeue;
-    substrate::PaddedLock<Concurrent> enqueue_lock;
-    substrate::PaddedLock<Concurrent> dequeue_lock;
-
-    bool minnow_thread;
-    bool done = false;
+    // Worker to helper and back. The worker also keeps the pushes that did
+    // not fit in the enqueue ring until the helper catches up.
+    internal::MinnowRing<T, MINNOW_RING_SIZE> enqueue;
+    internal::MinnowRing<T, MINNOW_DEQUEUE_SIZE> dequeue;
+    std::deque<T> overflow;
+    size_t overflows = 0;
+
+    // Helpers only: end of the last sweep and time in sweeps that found
+    // no work
+    std::chrono::steady_clock::time_point lastSweep;
+    std::chrono::steady_clock::duration idle{0};
+
+    // Placement. A helper serves workers; a worker is served by helper,
+    // which is its own tid if it runs its buckets itself.
+    bool is_helper  = false;
+    unsigned helper = 0;
+    std::vector<unsigned> workers;
     
     LMapTy local;
     Index curIndex;
@@ -733,7 +1411,8 @@ private:
   };
 
 
-  int minnow_threads;
+  unsigned helpers = 0;
+  unsigned pdLeader = 0; // worker that samples priority drift
   typedef std::deque<std::pair<Index, CTy*>> MasterLog;
 
   // NB: Place dynamically growing masterLog after fixed-size PerThreadStorage
@@ -833,11 +1512,141 @@ private:
     return slowUpdateLocalOrCreate(p, i);
   }
 
+  //! Helper side: file a task pushed by worker w into w's buckets
+  void helperPush(ThreadData& w, const value_type& val) {
+    Index index = indexer(val);
+    assert(!UseMonotonic || this->compare(w.curIndex, index));
+    // Fast path
+    if (index == w.curIndex && w.current) {
+      w.current->push(val);
+      return;
+    }
+
+    // Slow path
+    CTy* C = updateLocalOrCreate(w, index);
+    if (BSP && this->compare(index, w.scanStart))
+      w.scanStart = index;
+    // Opportunistically move to higher priority work
+    if (!UseBarrier && this->compare(index, w.curIndex)) {
+      w.curIndex = index;
+      w.current  = C;
+    }
+    C->push(val);
+  }
+
+  //! Helper side: take the next task for worker w out of its buckets
+  galois::optional<value_type> helperPop(ThreadData& w) {
+    // Find a successful pop
+    CTy* C = w.current;
+
+    if (this->hasStored(w, w.curIndex))
+      return this->popStored(w, w.curIndex);
+
+    if (!UseBarrier && BlockPeriod &&
+        (w.numPops++ & ((1 << BlockPeriod) - 1)) == 0)
+      return slowPop(w);
+
+    galois::optional<value_type> item;
+    if (C && (item = C->pop()))
+      return item;
+
+    if (UseBarrier)
+      return item;
+
+    // Slow path
+    return slowPop(w);
+  }
+
+  //! Helper side: move everything worker w pushed into its buckets
+  bool helperDrain(ThreadData& w) {
+    T buf[MINNOW_BATCH];
+    unsigned n, moved = 0;
+    // bounded so a worker that keeps pushing cannot starve the others
+    while (moved < MINNOW_RING_SIZE &&
+           (n = w.enqueue.pop_bulk(buf, MINNOW_BATCH))) {
+      for (unsigned k = 0; k < n; ++k)
+        helperPush(w, buf[k]);
+      moved += n;
+    }
+    return moved;
+  }
+
+  //! Helper side: top worker w's dequeue ring up to MINNOW_PREFETCH tasks
+  bool helperRefill(ThreadData& w) {
+    T buf[MINNOW_PREFETCH];
+    unsigned n          = 0;
+    unsigned long ready = w.dequeue.size();
+    while (ready + n < MINNOW_PREFETCH) {
+      galois::optional<value_type> item = helperPop(w);
+      if (!item)
+        break;
+      buf[n++] = *item;
+    }
+    // Fits, as ready never undercounts for the producer and push_bulk
+    // rereads the consumer index before leaving anything over. Should that
+    // ever change, keep the rest in w's buckets rather than lose it.
+    T* left = w.dequeue.push_bulk(buf, buf + n);
+    assert(left == buf + n);
+    for (; left != buf + n; ++left)
+      helperPush(w, *left);
+    return n;
+  }
+
+  //! Worker side: hand pushes held back by a full ring to the helper
+  void flushOverflow(ThreadData& p) {
+    auto ii = p.enqueue.push_bulk(p.overflow.begin(), p.overflow.end());
+    p.overflow.erase(p.overflow.begin(), ii);
+  }
+
 public:
-  OrderedByIntegerMetricMinn(const Indexer& x = Indexer(), int minnow_threads = 0)
-      : data(this->identity), masterVersion(0), indexer(x), minnow_threads(minnow_threads) {}
+  OrderedByIntegerMetricMinn(const Indexer& x = Indexer(),
+                             const MinnowConfig& cfg = MinnowConfig())
+      : data(this->identity), masterVersion(0), indexer(x) {
+    std::vector<int> helperOf =
+        internal::minnowPlacement(cfg, runtime::activeThreads);
+    pdLeader = runtime::activeThreads;
+    for (unsigned t = 0; t < runtime::activeThreads; ++t) {
+      ThreadData& p = *data.getRemote(t);
+      if (helperOf[t] < 0) {
+        p.is_helper = true;
+        ++helpers;
+        continue;
+      }
+      p.helper = helperOf[t];
+      if (p.helper != t)
+        data.getRemote(p.helper)->workers.push_back(t);
+      pdLeader = std::min(pdLeader, t);
+    }
+
+    onEachThread([this] {
+      unsigned tid  = substrate::ThreadPool::getTID();
+      ThreadData& p = *data.getLocal();
+      if (!p.is_helper && p.helper != tid) {
+        p.enqueue.allocate();
+        p.dequeue.allocate();
+      }
+      p.lastSweep = std::chrono::steady_clock::now();
+    });
+  }
 
   ~OrderedByIntegerMetricMinn() {
+    size_t overflows = 0;
+    for (unsigned i = 0; i < runtime::activeThreads; ++i)
+      overflows += data.getRemote(i)->overflows;
+    runtime::reportStat_Single("Minnow", "Helpers", helpers);
+    runtime::reportStat_Single("Minnow", "RingOverflows", overflows);
+
+    long idleMax = 0, idleTotal = 0;
+    for (unsigned i = 0; i < runtime::activeThreads; ++i) {
+      long us = std::chrono::duration_cast<std::chrono::microseconds>(
+                    data.getRemote(i)->idle)
+                    .count();
+      idleMax = std::max(idleMax, us);
+      idleTotal += us;
+    }
+    runtime::reportStat_Single("Minnow", "HelperIdleUs", idleMax);
+    runtime::reportStat_Single("Minnow", "HelperIdleUsTotal", idleTotal);
+
     // Deallocate in LIFO order to give opportunity for simple garbage
     // collection
     for (auto ii = masterLog.rbegin(), ei = masterLog.rend(); ii != ei; ++ii) {
@@ -847,192 +1656,128 @@ public:
 
   void push(const value_type& val) {
     ThreadData& p = *data.getLocal();
-    p.enqueue_lock.lock();
-    p.minnow_enqueue.push(val);
-    p.enqueue_lock.unlock();
-    return;
+    if (p.helper == substrate::ThreadPool::getTID()) {
+      helperPush(p, val);
+      return;
+    }
+    if (p.overflow.empty() && p.enqueue.try_push(val))
+      return;
+    p.overflow.push_back(val);
+    ++p.overflows;
+  }
+
+  template <typename Iter>
+  void push(Iter b, Iter e) {
+    ThreadData& p = *data.getLocal();
+    if (p.helper == substrate::ThreadPool::getTID()) {
+      for (; b != e; ++b)
+        helperPush(p, *b);
+      return;
+    }
+    if (p.overflow.empty())
+      b = p.enqueue.push_bulk(b, e);
+    for (; b != e; ++b) {
+      p.overflow.push_back(*b);
+      ++p.overflows;
+    }
   }
-  
+
   galois::optional<value_type> pop() {
     
     ThreadData& p = *data.getLocal();
-    int minnow_thread_id = substrate::ThreadPool::getTID();  
-    int minnow_threads_start = runtime::activeThreads - minnow_threads;
-    int minnow_workers_per_core = minnow_threads_start / minnow_threads;
-    if (minnow_thread_id >= minnow_threads_start) {
-      int start = 0; int end = 0;
-      int thread_index = minnow_thread_id - minnow_threads_start;
-      start = minnow_workers_per_core * thread_index;
-      end = start + (minnow_workers_per_core - 1);
-
-      bool work_done = false;
-      int work_done_counter = 0;
-      while (!p.done) {
-        
-        for (int i = start; i < end; i++) {
-        T val;
-        /* POP */
-        work_done = false;
-        while(true) {
-          data.getRemote(i)->enqueue_lock.lock();
-          if (data.getRemote(i)->minnow_enqueue.empty()) {data.getRemote(i)->enqueue_lock.unlock(); break;}
-          
-          val = data.getRemote(i)->minnow_enqueue.front(); data.getRemote(i)->minnow_enqueue.pop();
-          data.getRemote(i)->enqueue_lock.unlock();
-
-          Index index   = indexer(val);
-          assert(!UseMonotonic ||this->compare(data.getRemote(i)->curIndex, index));
-          work_done = true;
-          // Fast path
-          if (index == data.getRemote(i)->curIndex && data.getRemote(i)->current) {
-            data.getRemote(i)->current->push(val);
-            continue;
-          }
-
-          // Slow path
-          CTy* C = updateLocalOrCreate(*data.getRemote(i), index);
-          if (BSP && this->compare(index, data.getRemote(i)->scanStart))
-            data.getRemote(i)->scanStart = index;
-          // Opportunistically move to higher priority work
-          if (!UseBarrier && this->compare(index, data.getRemote(i)->curIndex)) {
-            data.getRemote(i)->curIndex = index;
-            data.getRemote(i)->current  = C;
-          }
-          C->push(val);
-        }
-      }
-
-
-      for (int i = start; i < end; i++) {
-        CTy* C  = data.getRemote(i)->current;
-        
-        
-        if (this->hasStored(*data.getRemote(i), data.getRemote(i)->curIndex)) {
-            galois::optional<value_type> item;
-            item = this->popStored(*data.getRemote(i), data.getRemote(i)->curIndex);
-            
-            if (item.is_initialized()) {
-              data.getRemote(i)->dequeue_lock.lock();
-              data.getRemote(i)->minnow_dequeue.push(item);
-              data.getRemote(i)->dequeue_lock.unlock();
-              work_done = true;
-            }
-            continue;
-
-          }
-        
-        if (!UseBarrier && BlockPeriod &&
-            (data.getRemote(i)->numPops++ & ((1 << BlockPeriod) - 1)) == 0) {
-            galois::optional<value_type> item;
-            item = slowPop(*data.getRemote(i));
- 
-            if (item.is_initialized()) {
-              data.getRemote(i)->dequeue_lock.lock();
-              data.getRemote(i)->minnow_dequeue.push(item); 
-              data.getRemote(i)->dequeue_lock.unlock();
-              work_done = true;
-            }
-            continue;
-          }
-
-        galois::optional<value_type> item;
-        if (C && (item = C->pop())) {
-          if (item.is_initialized()) {
-            data.getRemote(i)->dequeue_lock.lock();
-            data.getRemote(i)->minnow_dequeue.push(item);
-            data.getRemote(i)->dequeue_lock.unlock();
-            work_done = true;
-          }
-          continue;
-        }
-    
-        if (UseBarrier) {
-          if (item.is_initialized()) {
-            data.getRemote(i)->dequeue_lock.lock();
-            data.getRemote(i)->minnow_dequeue.push(item);
-            data.getRemote(i)->dequeue_lock.unlock();
-            work_done = true;
-          }
+    unsigned tid  = substrate::ThreadPool::getTID();
+    if (p.is_helper) {
+      // A helper never returns a task, so the executor always sees it as
+      // idle. It serves its workers until a sweep moves nothing and their
+      // rings are empty, then returns an empty pop so that the termination
+      // token can pass; the executor keeps calling pop until the whole loop
+      // terminates. Waiting for the dequeue rings matters: a task the helper
+      // handed out is not counted as work until its worker pops it.
+      for (;;) {
+        bool work_done = false;
+        for (unsigned w : p.workers)
+          work_done |= helperDrain(*data.getRemote(w));
+        for (unsigned w : p.workers)
+          work_done |= helperRefill(*data.getRemote(w));
+
+        auto now = std::chrono::steady_clock::now();
+        if (!work_done)
+          p.idle += now - p.lastSweep;
+        p.lastSweep = now;
+        if (work_done)
           continue;
-        }
-          
 
-        // Slow path
-        item = slowPop(*data.getRemote(i));
-        if (item.is_initialized()) {
-          data.getRemote(i)->dequeue_lock.lock();
-          data.getRemote(i)->minnow_dequeue.push(item);
-          data.getRemote(i)->dequeue_lock.unlock();
-          work_done = true;
-        }
-        continue;
+        /* Check termination condition */
+        bool quiet = true;
+        for (unsigned w : p.workers)
+          quiet = quiet && data.getRemote(w)->enqueue.empty() &&
+                  data.getRemote(w)->dequeue.empty();
+        if (quiet)
+          return galois::optional<value_type>();
+        substrate::asmPause();
       }
-      /* Check termination condition */
-      if (work_done == false) {
-        for (int i = start; i < end; i++) {
-          if (data.getRemote(i)->minnow_enqueue.empty() && data.getRemote(i)->minnow_dequeue.empty()) {
-            
-          }
-        }
-      }
-        work_done_counter++;
-        if (work_done_counter == 65536*28) {
-          break;
-        }
-    }
-     
     }
     else {
       galois::optional<value_type> retval;
-      p.dequeue_lock.lock();
-      if (p.minnow_dequeue.empty()) { p.dequeue_lock.unlock(); return retval;}
-      else {
-        retval = p.minnow_dequeue.front(); p.minnow_dequeue.pop();
-        p.dequeue_lock.unlock();
-
-        if (substrate::ThreadPool::getTID() == 0) {
-          int pd_temp = 0;
-        /* Priority drift logic */
-          if (p.pd_counter == 2000) {
-            sync = true;
-          }
-          if (p.pd_counter == 2100) {
-            sync = false;
-            p.pd_counter = 0;
+      if (p.helper == tid) {
+        // No helper: run the buckets here
+        if (!(retval = helperPop(p)))
+          return retval;
+      } else {
+        T val;
+        if (!p.overflow.empty())
+          flushOverflow(p);
+        if (!p.dequeue.try_pop(val)) {
+          if (p.overflow.empty())
+            return retval;
+          // The helper is behind and the ring is full: run the oldest held
+          // back task here instead of waiting for it
+          val = p.overflow.front();
+          p.overflow.pop_front();
+        }
+        retval = val;
+      }
+
+      if (tid == pdLeader) {
+        int pd_temp = 0;
+      /* Priority drift logic */
+        if (p.pd_counter == 2000) {
+          sync = true;
+        }
+        if (p.pd_counter == 2100) {
+          sync = false;
+          p.pd_counter = 0;
+        
+          for (unsigned i = 0; i < runtime::activeThreads; i++) {
+            if (i == tid || data.getRemote(i)->is_helper)
+              continue;
+            int pd_ = p.latest_index - data.getRemote(i)->latest_index;
+            pd_temp += abs(pd_ * 512);
+          } 
+          pd = (pd + pd_temp) / 2;
+          std::cout << "PD " << pd << std::endl;
           
-            for (int i = 1; i < 6; i++) {
-              int pd_ = p.latest_index - data.getRemote(i)->latest_index;
-              pd_temp += abs(pd_ * 512);
-            } 
-            pd = (pd + pd_temp) / 2;
-            std::cout << "PD " << pd << std::endl;
-            
-          }
         }
-        p.pd_counter++;
-        if (sync == true) p.latest_index = indexer(retval.get());
-        return retval;
       }
+      p.pd_counter++;
+      if (sync == true) p.latest_index = indexer(retval.get());
+      return retval;
     }
-    p.done = true;
-    galois::optional<value_type> retval;
-    return retval;
-
-  }
-
-  template <typename Iter>
-  void push(Iter b, Iter e) {
-    while (b != e)
-      push(*b++);
   }
 
   template <typename RangeTy>
   void push_initial(const RangeTy& range) {
-    
-    if (substrate::ThreadPool::getTID() == 0) {
-      auto rp = range.local_pair();
+    auto rp       = range.local_pair();
+    ThreadData& p = *data.getLocal();
+    if (!p.is_helper) {
       push(rp.first, rp.second);
+      return;
     }
+    // A helper has no rings of its own. It files its share straight into
+    // the buckets of its first worker, which only it touches.
+    ThreadData& w = *data.getRemote(p.workers.front());
+    for (auto ii = rp.first; ii != rp.second; ++ii)
+      helperPush(w, *ii);
   }
 
 
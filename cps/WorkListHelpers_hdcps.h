@@ -25,12 +25,26 @@
 #include "WLCompileCheck.h"
 #include "../PriorityQueue.h"
 #include "galois/substrate/PtrLock.h"
+#include "galois/substrate/CompilerSpecific.h"
+#include "galois/substrate/CacheLineStorage.h"
+#include "galois/substrate/NumaMem.h"
+#include "galois/runtime/Mem.h"
+#include "galois/runtime/Statistics.h"
 #include "galois/FlatMap.h"
 #include <boost/iterator/iterator_facade.hpp>
+#include <boost/iterator/transform_iterator.hpp>
 #include <iostream>
 #include <queue>
 #include <cmath>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
 
 using namespace std;
 namespace galois {
@@ -243,602 +257,1790 @@ GALOIS_WLCOMPILECHECK(SwarmPQ)
 #include <vector>
 using namespace std;
 
+//! Bytes per storage block of the CPS local queues
+#define CPS_HEAP_BLOCK (64 * 1024)
+
+namespace internal {
+constexpr unsigned floorLog2(size_t n) { return n <= 1 ? 0 : 1 + floorLog2(n / 2); }
+} // namespace internal
+
+/**
+ * Growable array backing the CPS local queues. Items live in fixed-size
+ * blocks from a Galois FixedSizeHeap, so growing adds a block instead of
+ * copying every item, and blocks come from the page pool of the thread that
+ * allocates them. Item i is at blocks[i >> SHIFT][i & MASK].
+ *
+ * Shrinking hands blocks back to the heap but keeps one spare, so a queue
+ * hovering around a block boundary does not allocate on every push. reset()
+ * returns everything; the worklists call it at the end of each run. The
+ * largest footprint seen is kept for the worklist stats.
+ */
 template <typename T>
-class RELD : private boost::noncopyable {
-/* Lock */
-using Lock_ty = galois::substrate::SimpleLock;
+class SegmentedVector : private boost::noncopyable {
+  static const unsigned SHIFT =
+      internal::floorLog2(CPS_HEAP_BLOCK / sizeof(T));
+  static const size_t PER_BLOCK   = size_t(1) << SHIFT;
+  static const size_t MASK        = PER_BLOCK - 1;
+  static const size_t BLOCK_BYTES = PER_BLOCK * sizeof(T);
+
+  runtime::FixedSizeHeap heap;
+  std::vector<T*> blocks;
+  size_t n          = 0;
+  size_t peak_blocks = 0;
+
+  void grow() {
+    blocks.push_back(static_cast<T*>(heap.allocate(BLOCK_BYTES)));
+    peak_blocks = std::max(peak_blocks, blocks.size());
+  }
+
+  //! Give back blocks beyond the ones in use plus one spare
+  void trim() {
+    size_t keep = ((n + MASK) >> SHIFT) + 1;
+    while (blocks.size() > keep) {
+      heap.deallocate(blocks.back());
+      blocks.pop_back();
+    }
+  }
 
-bool sync = false;
-unsigned int pd = 0;
+  void destroy() {
+    if (!std::is_trivially_destructible<T>::value) {
+      for (size_t i = 0; i < n; ++i)
+        (*this)[i].~T();
+    }
+    n = 0;
+  }
 
-public:
-  struct ThreadData {
-    priority_queue<T> PQ;
-    Lock_ty m_mutex;
-    int remote_thread;
+  template <typename V>
+  class Iter : public boost::iterator_facade<Iter<V>, V,
+                                             std::random_access_iterator_tag> {
+    friend class boost::iterator_core_access;
+    friend class SegmentedVector;
+
+    SegmentedVector* v = nullptr;
+    ptrdiff_t i        = 0;
+
+    Iter(SegmentedVector* v, ptrdiff_t i) : v(v), i(i) {}
 
-    int pd_counter = 0;
-    unsigned int latest_index = 0;
+    V& dereference() const { return (*v)[i]; }
+    bool equal(const Iter& o) const { return i == o.i; }
+    void increment() { ++i; }
+    void decrement() { --i; }
+    void advance(ptrdiff_t k) { i += k; }
+    ptrdiff_t distance_to(const Iter& o) const { return o.i - i; }
+
+  public:
+    Iter() {}
   };
 
-  RELD() {
-    srand( (unsigned)time(NULL) );
-    
+public:
+  typedef T value_type;
+  typedef size_t size_type;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef Iter<T> iterator;
+  typedef Iter<const T> const_iterator;
+
+  SegmentedVector() : heap(BLOCK_BYTES) {}
+  ~SegmentedVector() { reset(); }
+
+  T& operator[](size_t i) { return blocks[i >> SHIFT][i & MASK]; }
+  const T& operator[](size_t i) const { return blocks[i >> SHIFT][i & MASK]; }
+
+  bool empty() const { return n == 0; }
+  size_t size() const { return n; }
+
+  T& front() { return (*this)[0]; }
+  const T& front() const { return (*this)[0]; }
+  T& back() { return (*this)[n - 1]; }
+  const T& back() const { return (*this)[n - 1]; }
+
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, n); }
+  const_iterator begin() const {
+    return const_iterator(const_cast<SegmentedVector*>(this), 0);
+  }
+  const_iterator end() const {
+    return const_iterator(const_cast<SegmentedVector*>(this), n);
   }
 
-  ~RELD() {
+  void push_back(const T& val) {
+    if ((n >> SHIFT) == blocks.size())
+      grow();
+    new (&(*this)[n]) T(val);
+    ++n;
+  }
 
+  template <typename I>
+  void append(I b, I e) {
+    for (; b != e; ++b)
+      push_back(*b);
   }
 
-  substrate::PerThreadStorage<ThreadData> data;
+  void pop_back() {
+    (*this)[--n].~T();
+    if ((n & MASK) == 0)
+      trim();
+  }
 
+  void reserve(size_t k) {
+    while (blocks.size() * PER_BLOCK < k)
+      grow();
+  }
+
+  //! Drop every item, keeping one block for reuse
+  void clear() {
+    destroy();
+    trim();
+  }
+
+  //! Drop every item and return all blocks to the heap
+  void reset() {
+    destroy();
+    for (T* b : blocks)
+      heap.deallocate(b);
+    blocks.clear();
+  }
+
+  size_t peak_bytes() const { return peak_blocks * BLOCK_BYTES; }
+};
+
+/**
+ * Priority of a task for the CPS worklists and their local queues; lower is
+ * more urgent. By default it is the task's dist member, found at compile
+ * time. Specialize PriorityTraits for task types that keep it elsewhere.
+ */
+template <typename T, typename = void>
+struct PriorityTraits;
+
+template <typename T>
+struct PriorityTraits<T, decltype((void)std::declval<const T&>().dist)> {
+  static unsigned get(const T& val) { return static_cast<unsigned>(val.dist); }
+};
+
+//! Heap order of the local queues: a < b when b is more urgent
+template <typename T>
+struct PriorityLess {
+  bool operator()(const T& a, const T& b) const {
+    return PriorityTraits<T>::get(a) > PriorityTraits<T>::get(b);
+  }
+};
+
+/*
+ * Local priority queues for the CPS worklists. Every queue is a max-heap on
+ * PriorityLess, so the top is the task with the lowest PriorityTraits value
+ * whatever its operator< says, and provides push, push_bulk, top, pop and
+ * empty. Worklists take one as their LocalQueue parameter and rebind it to
+ * their item type with retype. All of them keep their items in a
+ * SegmentedVector, so they also provide reserve, reset and peak_bytes.
+ */
+
+/**
+ * std::priority_queue that can absorb a batch of items at once. When the
+ * batch is at least as large as the heap it is cheaper to append everything
+ * and rebuild the heap in linear time than to sift each item up.
+ */
+template <typename T>
+class BulkPriorityQueue
+    : public std::priority_queue<T, SegmentedVector<T>, PriorityLess<T>> {
+public:
   template <typename _T>
-  using retype = RELD<_T>;
+  using retype = BulkPriorityQueue<_T>;
 
-  template <bool b>
-  using rethread = RELD;
+  void reserve(size_t n) { this->c.reserve(n); }
+  void reset() { this->c.reset(); }
+  size_t peak_bytes() const { return this->c.peak_bytes(); }
 
-  typedef T value_type;
+  template <typename Iter>
+  void push_bulk(Iter b, Iter e) {
+    size_t k = std::distance(b, e);
+    if (k >= this->c.size()) {
+      this->c.append(b, e);
+      std::make_heap(this->c.begin(), this->c.end(), this->comp);
+    } else {
+      for (; b != e; ++b)
+        this->push(*b);
+    }
+  }
+};
 
-  void push(const value_type& val) {
+/**
+ * Implicit D-ary heap. A wider node keeps all children of a parent in one
+ * or two cache lines and halves (D = 4) or thirds (D = 8) the depth of the
+ * tree, trading a few more comparisons per level for fewer cache misses on
+ * pop.
+ */
+template <typename T, unsigned D = 4>
+class DAryHeap {
+  static_assert(D >= 2, "heap arity must be at least 2");
+
+  SegmentedVector<T> c;
+  PriorityLess<T> comp;
+
+  void sift_up(size_t i) {
+    T v = c[i];
+    while (i > 0) {
+      size_t parent = (i - 1) / D;
+      if (!comp(c[parent], v))
+        break;
+      c[i] = c[parent];
+      i    = parent;
+    }
+    c[i] = v;
+  }
 
-    ThreadData& p = *data.getLocal();
-    p.remote_thread = std::rand() % runtime::activeThreads;
-    if (p.remote_thread == substrate::ThreadPool::getTID()) {
-      p.m_mutex.lock();
-      p.PQ.push(val);
-      p.m_mutex.unlock();
+  void sift_down(size_t i) {
+    size_t n = c.size();
+    T v      = c[i];
+    for (;;) {
+      size_t first = i * D + 1;
+      if (first >= n)
+        break;
+      size_t last = std::min(first + D, n);
+      size_t best = first;
+      for (size_t j = first + 1; j < last; ++j) {
+        if (comp(c[best], c[j]))
+          best = j;
+      }
+      if (!comp(v, c[best]))
+        break;
+      c[i] = c[best];
+      i    = best;
     }
-    else {
-      ThreadData& r = *data.getRemote(p.remote_thread);
-      r.m_mutex.lock();
-      r.PQ.push(val);
-      r.m_mutex.unlock();
+    c[i] = v;
+  }
+
+public:
+  template <typename _T>
+  using retype = DAryHeap<_T, D>;
+
+  bool empty() const { return c.empty(); }
+  size_t size() const { return c.size(); }
+  const T& top() const { return c.front(); }
+
+  void push(const T& val) {
+    c.push_back(val);
+    sift_up(c.size() - 1);
+  }
+
+  void reserve(size_t n) { c.reserve(n); }
+  void reset() { c.reset(); }
+  size_t peak_bytes() const { return c.peak_bytes(); }
+
+  template <typename Iter>
+  void push_bulk(Iter b, Iter e) {
+    size_t k = std::distance(b, e);
+    if (k >= c.size()) {
+      c.append(b, e);
+      for (size_t i = (c.size() + D - 2) / D; i-- > 0;)
+        sift_down(i);
+    } else {
+      for (; b != e; ++b)
+        push(*b);
     }
+  }
 
+  void pop() {
+    if (c.size() > 1) {
+      c.front() = c.back();
+      c.pop_back();
+      sift_down(0);
+    } else {
+      c.pop_back();
+    }
+  }
+};
+
+/**
+ * Monotone radix heap keyed on the integer <code>dist</code> member of the
+ * task. Items are kept in one bucket per bit of difference from the last
+ * extracted key, so push is O(1) and each item is moved at most once per
+ * bit over its lifetime. This suits SSSP/BFS where pushed distances are
+ * almost never below the distance being processed.
+ *
+ * Relaxed schedulers can still deliver a task below the last extracted key
+ * (e.g. a message from another thread); such tasks go to the front bucket
+ * and are returned before anything else, in no particular order among
+ * themselves.
+ */
+template <typename T>
+class MonotoneRadixHeap {
+  static const unsigned NUM_BUCKETS = sizeof(unsigned) * 8 + 1;
+
+  SegmentedVector<T> buckets[NUM_BUCKETS];
+  unsigned last = 0;
+  size_t count  = 0;
+
+  static unsigned key(const T& val) { return PriorityTraits<T>::get(val); }
+
+  unsigned bucket(unsigned k) const {
+    return k <= last ? 0 : sizeof(unsigned) * 8 - __builtin_clz(k ^ last);
+  }
+
+  //! Make sure bucket 0 holds the current minimum
+  void refill() {
+    if (!buckets[0].empty())
+      return;
+    unsigned i = 1;
+    while (buckets[i].empty())
+      ++i;
+    SegmentedVector<T>& b = buckets[i];
+    unsigned m        = key(b.front());
+    for (const T& v : b)
+      m = std::min(m, key(v));
+    last = m;
+    // every item in bucket i now differs from last below bit i - 1
+    for (const T& v : b)
+      buckets[bucket(key(v))].push_back(v);
+    b.clear();
+  }
+
+public:
+  template <typename _T>
+  using retype = MonotoneRadixHeap<_T>;
+
+  bool empty() const { return count == 0; }
+  size_t size() const { return count; }
+
+  //! Only bucket 0 is sized up front; it holds every item of one priority
+  void reserve(size_t n) { buckets[0].reserve(n); }
+
+  void reset() {
+    for (SegmentedVector<T>& b : buckets)
+      b.reset();
+    last  = 0;
+    count = 0;
+  }
+
+  //! Sum of the bucket peaks, an upper bound on the real peak
+  size_t peak_bytes() const {
+    size_t sum = 0;
+    for (const SegmentedVector<T>& b : buckets)
+      sum += b.peak_bytes();
+    return sum;
+  }
+
+  const T& top() {
+    refill();
+    return buckets[0].back();
+  }
+
+  void push(const T& val) {
+    buckets[bucket(key(val))].push_back(val);
+    ++count;
   }
 
   template <typename Iter>
-  void push(Iter b, Iter e) {
-    
-    for (; b!=e; ++b) {
+  void push_bulk(Iter b, Iter e) {
+    for (; b != e; ++b)
       push(*b);
+  }
+
+  void pop() {
+    refill();
+    buckets[0].pop_back();
+    --count;
+  }
+};
+
+//! Items each CPS thread reserves in its heap before the loop starts
+#define CPS_HEAP_RESERVE 1024
+
+/**
+ * Run f once on each active thread. The CPS worklists call it from their
+ * constructors so that every thread allocates and first-touches its own heap
+ * and message ring, which places them on that thread's NUMA node instead of
+ * the node of the thread constructing the worklist.
+ */
+template <typename F>
+void onEachThread(F f) {
+  substrate::getThreadPool().run(runtime::activeThreads, f);
+}
+
+/**
+ * Report the heap footprint of a run: the largest peak of any thread, which
+ * is what a node must hold per core, and the sum over all threads.
+ * bytesOf(tid) gives the peak of one thread.
+ */
+template <typename F>
+void reportHeapPeak(const char* region, F bytesOf) {
+  size_t max = 0, sum = 0;
+  for (unsigned i = 0; i < runtime::activeThreads; ++i) {
+    size_t b = bytesOf(i);
+    max      = std::max(max, b);
+    sum += b;
+  }
+  runtime::reportStat_Single(region, "PeakHeapBytes", max);
+  runtime::reportStat_Single(region, "PeakHeapBytesTotal", sum);
+}
+
+//! Do threads a and b run on different NUMA nodes
+inline bool crossNode(unsigned a, unsigned b) {
+  return substrate::getThreadPool().getSocket(a) !=
+         substrate::getThreadPool().getSocket(b);
+}
+
+/**
+ * Global priority drift estimate shared by the CPS worklists. Every thread
+ * stores the priority it last popped into its own padded slot. Whichever
+ * thread notices that the sampling period has elapsed takes the sample: it
+ * sums how far every busy thread lags behind the most urgent one and
+ * publishes the result, which any thread can read with get(). Sampling is
+ * time based and not tied to a particular thread, so the estimate keeps
+ * moving when thread 0 stalls or runs out of work.
+ */
+class DriftMonitor : private boost::noncopyable {
+public:
+  static const unsigned IDLE = std::numeric_limits<unsigned>::max();
+
+private:
+  //! Pops between two reads of the clock
+  static const unsigned CLOCK_CHECK = 64;
+
+  struct Slot {
+    std::atomic<unsigned> prio;
+    unsigned pops;
+    Slot() : prio(IDLE), pops(0) {}
+  };
+
+  substrate::PerThreadStorage<substrate::CacheLineStorage<Slot>> slots;
+  substrate::CacheLineStorage<std::atomic<unsigned long>> drift;
+  substrate::CacheLineStorage<std::atomic<unsigned long>> next_sample;
+  std::atomic<bool> sampling;
+  unsigned long period_ns;
+  std::chrono::steady_clock::time_point start;
+
+  unsigned long now() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+  }
+
+  unsigned long sample() {
+    unsigned min_prio = IDLE;
+    for (unsigned i = 0; i < runtime::activeThreads; ++i) {
+      min_prio = std::min(min_prio, slots.getRemote(i)->data.prio.load(
+                                        std::memory_order_relaxed));
+    }
+    if (min_prio == IDLE)
+      return 0;
+    unsigned long sum = 0;
+    for (unsigned i = 0; i < runtime::activeThreads; ++i) {
+      unsigned prio =
+          slots.getRemote(i)->data.prio.load(std::memory_order_relaxed);
+      if (prio != IDLE)
+        sum += prio - min_prio;
     }
+    return sum;
+  }
 
+public:
+  explicit DriftMonitor(unsigned period_us = 1000)
+      : sampling(false), period_ns(period_us * 1000ul),
+        start(std::chrono::steady_clock::now()) {
+    drift.data.store(0, std::memory_order_relaxed);
+    next_sample.data.store(period_ns, std::memory_order_relaxed);
   }
 
-  template <typename RangeTy>
-  void push_initial(const RangeTy& range) {
-    if (substrate::ThreadPool::getTID() == 0) {push(range.begin(), range.end());}  
+  //! Latest published drift
+  unsigned long get() const {
+    return drift.data.load(std::memory_order_relaxed);
+  }
+
+  //! The calling thread has nothing to pop
+  void idle() {
+    slots.getLocal()->data.prio.store(IDLE, std::memory_order_relaxed);
   }
-  
-  galois::optional<value_type> pop() { 
-    
-    ThreadData& p = *data.getLocal();
-    p.m_mutex.lock();
 
-    if (p.PQ.empty()) {
-        p.m_mutex.unlock(); 
-        return galois::optional<value_type>();
+  /**
+   * Record the priority the calling thread is about to pop. If this call
+   * takes a new sample, onSample(drift) runs before the sample is released,
+   * so callbacks never run concurrently with each other.
+   *
+   * @returns true if a new sample was published
+   */
+  template <typename F>
+  bool record(unsigned prio, F&& onSample) {
+    Slot& s = slots.getLocal()->data;
+    s.prio.store(prio, std::memory_order_relaxed);
+    if (++s.pops % CLOCK_CHECK)
+      return false;
+
+    unsigned long t = now();
+    if (t < next_sample.data.load(std::memory_order_relaxed) ||
+        sampling.exchange(true, std::memory_order_acquire))
+      return false;
+    if (t < next_sample.data.load(std::memory_order_relaxed)) {
+      sampling.store(false, std::memory_order_release);
+      return false;
     }
-    
-    galois::optional<value_type> retval;
-    
-    /* PD */
-    if (sync == true) {
-      p.latest_index = p.PQ.top().dist;
+
+    unsigned long d = sample();
+    drift.data.store(d, std::memory_order_relaxed);
+    onSample(d);
+    next_sample.data.store(t + period_ns, std::memory_order_relaxed);
+    sampling.store(false, std::memory_order_release);
+    return true;
+  }
+};
+
+/**
+ * Settings for the task distribution factor (TDF) of HDCPS and HDCPS_BR. A
+ * push stays local while the per-thread counter is at most the factor, and
+ * the counter wraps at den, so roughly (factor + 1) / den of all pushes stay
+ * local. Bounds, step and init are in the same units as the factor.
+ */
+struct TDFConfig {
+  enum Policy { HILL_CLIMB, PID, FIXED };
+
+  Policy policy;
+  int min;
+  int max;
+  int step;
+  int init;
+  int den;
+  //! Drift sampling period
+  unsigned period_us;
+  //! PID gains, applied to the drift error relative to target
+  double kp;
+  double ki;
+  double kd;
+  //! Drift the PID policy steers towards
+  unsigned long target;
+  //! Print every adaptation decision. Off by default: update() runs inside
+  //! pop(), so the printing lands on the hot path of timed runs.
+  bool log;
+  /**
+   * Only send tasks that are at least as urgent as the local heap top, and
+   * only to receivers that are working on something less urgent. The factor
+   * still bounds how many of those get sent.
+   */
+  bool priority_aware;
+
+  TDFConfig(int min, int max, int den)
+      : policy(HILL_CLIMB), min(min), max(max), step(1), init(max), den(den),
+        period_us(1000), kp(0.5), ki(0.1), kd(0.0), target(1000), log(false),
+        priority_aware(false) {}
+};
+
+/**
+ * Adapts the task distribution factor from drift samples. update() is only
+ * called from a DriftMonitor callback, so policies keep their state without
+ * locking; get() is read by every push.
+ */
+class TDFController : private boost::noncopyable {
+  std::atomic<int> factor;
+
+protected:
+  const TDFConfig cfg;
+
+  int clamp(int f) const { return std::max(cfg.min, std::min(f, cfg.max)); }
+
+  //! Next factor for this drift sample
+  virtual int decide(unsigned long drift, int current) = 0;
+  virtual const char* name() const                     = 0;
+
+public:
+  explicit TDFController(const TDFConfig& c) : cfg(c) {
+    factor.store(clamp(c.init), std::memory_order_relaxed);
+  }
+  virtual ~TDFController() {}
+
+  static std::unique_ptr<TDFController> make(const TDFConfig& c);
+
+  int get() const { return factor.load(std::memory_order_relaxed); }
+  int den() const { return cfg.den; }
+  unsigned period() const { return cfg.period_us; }
+
+  void update(unsigned long drift) {
+    int cur  = get();
+    int next = clamp(decide(drift, cur));
+    factor.store(next, std::memory_order_relaxed);
+    if (cfg.log) {
+      std::cout << "TDF " << name() << " drift " << drift << " factor " << cur
+                << " -> " << next << "/" << cfg.den << std::endl;
     }
+  }
+};
 
-    retval = p.PQ.top(); p.PQ.pop();
-    p.m_mutex.unlock();
-    
-    if (substrate::ThreadPool::getTID() == 0) {
-      int pd_temp = 0;
-      /* Priority drift logic */
-      if (p.pd_counter == 2000) {
-        sync = true;
+//! The original HD-CPS policy: keep moving while drift improves, else reverse
+class HillClimbTDF : public TDFController {
+  unsigned long prev = 0;
+  bool prev_decision = false; // false decrease
+  bool first_iter    = true;
+
+protected:
+  const char* name() const { return "hill-climb"; }
+
+  int decide(unsigned long pd, int df) {
+    if (first_iter) {
+      first_iter = false;
+    }
+    else {
+      if (pd >= prev && prev_decision == true) {
+        df += cfg.step; // decrease TDF
+        prev_decision = false;
+      }
+      else if (pd >= prev && prev_decision == false) {
+        df -= cfg.step; // increase tdf
+        prev_decision = true;
       }
-      if (p.pd_counter == 2100) {
-        sync = false;
-        p.pd_counter = 0;
-        
-        for (int i = 1; i <  runtime::activeThreads; i++) {
-          int pd_ = p.latest_index - data.getRemote(i)->latest_index;
-          pd_temp += abs(pd_ * 64);
-        } 
-        pd = (pd + pd_temp) / 2;
-        std::cout << "PD " << pd << std::endl;
-        
+      else {
+        df += cfg.step; // decrease TDF
+        prev_decision = false;
       }
     }
-    p.pd_counter++;
+    prev = pd;
+    return df;
+  }
 
+public:
+  explicit HillClimbTDF(const TDFConfig& c) : TDFController(c) {}
+};
 
-    return retval;
+/**
+ * PID on the drift error, normalized by the target so the gains do not depend
+ * on the priority scale of the workload. The output is a fraction of the
+ * [min, max] range; drift above target distributes more. The integral is
+ * frozen while the factor is saturated.
+ */
+class PIDTDF : public TDFController {
+  double integral = 0;
+  double prev_err = 0;
+  bool first_iter = true;
+
+protected:
+  const char* name() const { return "pid"; }
+
+  int decide(unsigned long drift, int) {
+    double norm = cfg.target ? (double)cfg.target : 1.0;
+    double err  = ((double)drift - (double)cfg.target) / norm;
+    double deriv = first_iter ? 0.0 : err - prev_err;
+    first_iter   = false;
+    prev_err     = err;
+
+    double u = cfg.kp * err + cfg.ki * (integral + err) + cfg.kd * deriv;
+    int next = cfg.init - (int)std::lround(u * (cfg.max - cfg.min));
+    if (next == clamp(next)) {
+      integral += err;
+    }
+    return next;
   }
+
+public:
+  explicit PIDTDF(const TDFConfig& c) : TDFController(c) {}
 };
-GALOIS_WLCOMPILECHECK(RELD)
 
-#define MSG_QUEUE_SIZE 512
+class FixedTDF : public TDFController {
+protected:
+  const char* name() const { return "fixed"; }
+  int decide(unsigned long, int) { return cfg.init; }
+
+public:
+  explicit FixedTDF(const TDFConfig& c) : TDFController(c) {}
+};
+
+inline std::unique_ptr<TDFController>
+TDFController::make(const TDFConfig& c) {
+  switch (c.policy) {
+  case TDFConfig::PID:
+    return std::unique_ptr<TDFController>(new PIDTDF(c));
+  case TDFConfig::FIXED:
+    return std::unique_ptr<TDFController>(new FixedTDF(c));
+  default:
+    return std::unique_ptr<TDFController>(new HillClimbTDF(c));
+  }
+}
+
+//! Per-thread xorshift generator for picking queues and victims
+struct XorShift {
+  unsigned long state = 0;
+
+  //! Seed once from the thread id; later calls are no-ops
+  void seed(unsigned tid) {
+    if (!state)
+      state = (tid + 1) * 0x9E3779B97F4A7C15ul;
+  }
 
-template <typename T, class Indexer = DummyIndexer<int>>
-class HDCPS : private boost::noncopyable {
+  unsigned long next() {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+  }
+};
 
-/* PD */
-bool sync = false;
-unsigned int pd = 0;
-unsigned int pd_prev = 0;
-bool prev_decision = false; // false decrease
-bool first_iter = true;
-int dist_factor = 8;
-int dist_factor_prev = 8;
-int dist_factor_den = 10;
+/**
+ * Per-thread staging area for bulk pushes: tasks are grouped by receiving
+ * thread so that each receiver is touched once per batch.
+ */
+template <typename T>
+class Outbox {
+  std::vector<std::vector<T>> box;
+  std::vector<unsigned> touched;
 
 public:
+  void add(unsigned dst, const T& val) {
+    if (box.size() <= dst)
+      box.resize(runtime::activeThreads);
+    if (box[dst].empty())
+      touched.push_back(dst);
+    box[dst].push_back(val);
+  }
+
+  //! Call f(dst, batch) for every receiver with tasks, then empty the outbox
+  template <typename F>
+  void flush(F&& f) {
+    for (unsigned dst : touched) {
+      f(dst, box[dst]);
+      box[dst].clear();
+    }
+    touched.clear();
+  }
+};
+
+/**
+ * Relaxed priority queue in the MultiQueue style: c heaps per thread, each
+ * behind its own padded try-lock. A push locks a random heap, and a pop takes
+ * the better top of two random heaps. Neither one blocks: if a try-lock
+ * fails it retries on other heaps. Each heap publishes the priority of its
+ * top so that pops compare candidates without taking locks. Threads draw
+ * heap indices from their own xorshift generator.
+ */
+template <typename T, typename LocalQueue = BulkPriorityQueue<T>>
+class RELD_MQ : private boost::noncopyable {
+  using Lock_ty = galois::substrate::SimpleLock;
+
+  struct Queue {
+    typename LocalQueue::template retype<T> PQ;
+    Lock_ty lock;
+    //! Priority of PQ.top(), DriftMonitor::IDLE when empty
+    std::atomic<unsigned> top{DriftMonitor::IDLE};
+
+    void publish() {
+      top.store(PQ.empty() ? DriftMonitor::IDLE
+                           : PriorityTraits<T>::get(PQ.top()),
+                std::memory_order_relaxed);
+    }
+  };
+
   struct ThreadData {
-    ThreadData() {
-      msg_queue =  new T[MSG_QUEUE_SIZE];
-    }
-    priority_queue<T> PQ;
-    int ctr = 0;
-    T *msg_queue;
-    unsigned long msg_loc_curr; 
-    unsigned long msg_loc = 0;
-    int rr = substrate::ThreadPool::getTID();
-    
-    /* PD */
-    int pd_counter = 0;
-    unsigned int latest_index = 0;
+    XorShift rng;
+    unsigned long retries = 0;
   };
 
-  HDCPS(const Indexer& x) : indexer(x) {
+  unsigned nq;
+  std::unique_ptr<substrate::CacheLineStorage<Queue>[]> queues;
+  substrate::PerThreadStorage<ThreadData> data;
+
+  /* PD */
+  unsigned int pd = 0;
+  DriftMonitor monitor;
+
+  Queue& queue(unsigned i) { return queues[i].data; }
 
+  ThreadData& local() {
+    ThreadData& p = *data.getLocal();
+    p.rng.seed(substrate::ThreadPool::getTID());
+    return p;
   }
 
-  ~HDCPS() {
-    
+public:
+  explicit RELD_MQ(unsigned c = 2)
+      : nq(std::max(1u, c * runtime::activeThreads)),
+        queues(new substrate::CacheLineStorage<Queue>[nq]) {}
+
+  ~RELD_MQ() {
+    unsigned long retries = 0;
+    for (unsigned i = 0; i < runtime::activeThreads; ++i) {
+      retries += data.getRemote(i)->retries;
+    }
+    runtime::reportStat_Single("RELD_MQ", "LockRetries", retries);
+    // Heaps are not owned by threads; charge thread t with heaps t*c..t*c+c-1
+    unsigned c = nq / std::max(1u, (unsigned)runtime::activeThreads);
+    reportHeapPeak("RELD_MQ", [this, c](unsigned t) {
+      size_t b = 0;
+      for (unsigned i = t * c; i < (t + 1) * c && i < nq; ++i)
+        b += queue(i).PQ.peak_bytes();
+      return b;
+    });
   }
-  substrate::PerThreadStorage<ThreadData> data;
-  Indexer indexer;
 
   template <typename _T>
-  using retype = HDCPS<_T, Indexer>;
+  using retype = RELD_MQ<_T, typename LocalQueue::template retype<_T>>;
 
   template <bool b>
-  using rethread = HDCPS;
+  using rethread = RELD_MQ;
+
+  template <typename _lq>
+  struct with_local_queue {
+    typedef RELD_MQ<T, _lq> type;
+  };
 
   typedef T value_type;
 
   void push(const value_type& val) {
-    
-    ThreadData& p = *data.getLocal();
-    if (p.msg_loc != p.msg_loc_curr) {
-        p.PQ.push(p.msg_queue[p.msg_loc]);
-        p.msg_loc = (p.msg_loc + 1) % MSG_QUEUE_SIZE;
-    }
-    
-    if (p.ctr <= dist_factor) {
-      p.PQ.push(val);
-    }
-    else {
-      p.rr = (p.rr + 1) % runtime::activeThreads;
-      if (p.rr == substrate::ThreadPool::getTID()) {p.PQ.push(val);}
-      ThreadData& r = *data.getRemote(p.rr); 
-     
-      int loc = r.msg_loc_curr; r.msg_loc_curr = (r.msg_loc_curr + 1) % MSG_QUEUE_SIZE;
-      r.msg_queue[loc] = val; 
-      
+    ThreadData& p = local();
+    for (;;) {
+      Queue& q = queue(p.rng.next() % nq);
+      if (q.lock.try_lock()) {
+        q.PQ.push(val);
+        q.publish();
+        q.lock.unlock();
+        return;
+      }
+      p.retries++;
     }
-    
-    p.ctr = (p.ctr + 1) % dist_factor_den;
-    
   }
 
   template <typename Iter>
   void push(Iter b, Iter e) {
-    for (; b!=e; ++b) {
+    for (; b != e; ++b) {
       push(*b);
     }
- 
   }
 
   template <typename RangeTy>
   void push_initial(const RangeTy& range) {
-    if (substrate::ThreadPool::getTID() == 0){push(range.begin(), range.end());}  
-  }
-  
-  galois::optional<value_type> pop() { 
-    
-    ThreadData& p = *data.getLocal();
-   
-    unsigned long loc = p.msg_loc_curr;
-
-    if (p.msg_loc != loc) {
-        p.PQ.push(p.msg_queue[p.msg_loc]);
-        p.msg_loc = (p.msg_loc + 1) % MSG_QUEUE_SIZE;
+    if (substrate::ThreadPool::getTID() == 0) {
+      push(range.begin(), range.end());
     }
+  }
 
-    if (p.PQ.empty()) {
-        return galois::optional<value_type>();
-    }
-    galois::optional<value_type> retval;
-   
-    {
-      if (substrate::ThreadPool::getTID() == 0) {
-        /* Priority drift logic */
-        if (p.pd_counter == 2000) {
-          sync = true;
-        }
-        if (p.pd_counter == 2100) {
-          sync = false;
-          p.pd_counter = 0;
-          
-          for (int i = 1; i <  runtime::activeThreads; i++) {
-            int pd_ = p.latest_index - data.getRemote(i)->latest_index;
-            pd += abs(pd_);
-          }
+  galois::optional<value_type> pop() {
+    ThreadData& p = local();
+    for (;;) {
+      unsigned i = p.rng.next() % nq;
+      unsigned j = p.rng.next() % nq;
+      unsigned ti = queue(i).top.load(std::memory_order_relaxed);
+      unsigned tj = queue(j).top.load(std::memory_order_relaxed);
+      if (tj < ti) {
+        std::swap(i, j);
+        std::swap(ti, tj);
+      }
 
-          if (first_iter) {
-            pd_prev = pd;
-            first_iter = false;
-          }
-          else {
-            if (pd >= (pd_prev) && prev_decision == true) {
-              dist_factor = min(dist_factor + 1, 8); // decrease TDF
-              prev_decision = false;
-            }
-            else if (pd >= (pd_prev) && prev_decision == false) {
-              dist_factor = max(dist_factor - 1, 3); // increase tdf
-              prev_decision = true;
-            }
-            else {
-              dist_factor = min(dist_factor + 1, 8); // decrease TDF
-              prev_decision = false;
-            }
+      if (ti == DriftMonitor::IDLE) {
+        // Both picks are empty. Only report empty after a full scan, so an
+        // empty pop on every thread means every heap is empty.
+        i = nq;
+        for (unsigned k = 0; k < nq; ++k) {
+          if (queue(k).top.load(std::memory_order_relaxed) !=
+              DriftMonitor::IDLE) {
+            i = k;
+            break;
           }
-          std::cout << "PD " << pd << std::endl;
-          pd_prev = pd;
-          pd = 0;
-          
+        }
+        if (i == nq) {
+          monitor.idle();
+          return galois::optional<value_type>();
         }
       }
+
+      Queue& q = queue(i);
+      if (!q.lock.try_lock()) {
+        p.retries++;
+        continue;
+      }
+      if (q.PQ.empty()) {
+        q.lock.unlock();
+        continue;
+      }
+      galois::optional<value_type> retval(q.PQ.top());
+      q.PQ.pop();
+      q.publish();
+      q.lock.unlock();
+
+      /* PD */
+      monitor.record(PriorityTraits<T>::get(*retval),
+                     [&](unsigned long drift) {
+                       pd = (pd + drift * 64) / 2;
+                       std::cout << "PD " << pd << std::endl;
+                     });
+      return retval;
     }
-    p.pd_counter++;
-    
-    /* PD */
-    if (sync == true) {
-      p.latest_index = p.PQ.top().dist;
-    }
-    
-    retval = p.PQ.top(); p.PQ.pop();
-   
-    return retval;
   }
 };
-GALOIS_WLCOMPILECHECK(HDCPS)
+GALOIS_WLCOMPILECHECK(RELD_MQ)
+
+#define MSG_QUEUE_SIZE 512
+//! Cache lines per HDCPS message slot, sequence word included
+#define MSG_CHUNK_LINES 2
+
+/**
+ * Bounded multi-producer/single-consumer ring used by HDCPS to hand tasks to
+ * a remote thread. Each slot carries a sequence number: a sender claims a
+ * slot with one CAS on the tail and publishes the task with a release store
+ * of the sequence, the owner consumes it with a plain acquire load. Head and
+ * tail live on separate cache lines so senders do not ping-pong the line the
+ * owner is draining, and every slot is padded to whole cache lines so two
+ * senders never write the same line.
+ *
+ * try_push fails instead of overwriting when the ring is full; callers keep
+ * the task local in that case.
+ *
+ * A task counts as in flight from the moment its sender wins the tail CAS
+ * until the owner pops it, so in_flight() also covers a slot that is claimed
+ * but not yet published.
+ *
+ * The slots are allocated by allocate(), which the owner calls before any
+ * sender runs so that they live on the owner's NUMA node.
+ */
+template <typename T, unsigned Size = MSG_QUEUE_SIZE>
+class MessageRing : private boost::noncopyable {
+  static_assert((Size & (Size - 1)) == 0, "ring size must be a power of two");
 
-template <typename T, class Indexer = DummyIndexer<int>>
-class HDCPS_BR : private boost::noncopyable {
+  static const size_t LINE = sizeof(substrate::CacheLineStorage<char>);
+
+  struct Slot {
+    std::atomic<unsigned long> seq;
+    T val;
+  };
+  static const size_t STRIDE = (sizeof(Slot) + LINE - 1) / LINE * LINE;
 
-/* PD */
-bool sync = false;
-unsigned int pd = 0;
-unsigned int pd_prev = 0;
-bool prev_decision = false; // false decrease
-bool first_iter = true;
-int dist_factor = 8;
-int dist_factor_prev = 8;
-int dist_factor_den = 1;
+  substrate::CacheLineStorage<std::atomic<unsigned long>> tail; // senders
+  substrate::CacheLineStorage<std::atomic<unsigned long>> head; // owner
+  substrate::LAptr mem;
+  char* base = nullptr;
+
+  Slot& slot(unsigned long pos) const {
+    return *reinterpret_cast<Slot*>(base + (pos & (Size - 1)) * STRIDE);
+  }
 
 public:
-  struct WorkItem{
-    T first;
-    unsigned dist;
+  MessageRing() {
+    tail.data.store(0, std::memory_order_relaxed);
+    head.data.store(0, std::memory_order_relaxed);
+  }
 
-    WorkItem(const T& N, unsigned W): first(N), dist(W) {}
-    WorkItem(): first(), dist(0) {}
+  ~MessageRing() {
+    if (!base)
+      return;
+    for (unsigned long i = 0; i < Size; ++i)
+      slot(i).~Slot();
+  }
 
-    unsigned int operator() () const {
-      return dist;
+  //! Called by the owner, once. Pages come back aligned and faulted locally.
+  void allocate() {
+    mem  = substrate::largeMallocLocal(Size * STRIDE);
+    base = static_cast<char*>(mem.get());
+    for (unsigned long i = 0; i < Size; ++i) {
+      new (&slot(i)) Slot();
+      slot(i).seq.store(i, std::memory_order_relaxed);
     }
+  }
 
- 
-    friend bool operator<(const WorkItem& left,
-                          const WorkItem& right) {
-      return left.dist > right.dist;
+  //! Called by any thread. Returns false if the ring is full.
+  bool try_push(const T& val) {
+    unsigned long pos = tail.data.load(std::memory_order_relaxed);
+    for (;;) {
+      Slot& s           = slot(pos);
+      unsigned long seq = s.seq.load(std::memory_order_acquire);
+      long diff         = (long)seq - (long)pos;
+      if (diff == 0) {
+        if (tail.data.compare_exchange_weak(pos, pos + 1,
+                                            std::memory_order_relaxed)) {
+          s.val = val;
+          s.seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = tail.data.load(std::memory_order_relaxed);
+      }
     }
-  };
-
-  struct ThreadData {
-    ThreadData() {
-      msg_queue =  new WorkItem[MSG_QUEUE_SIZE];
-    }
-    priority_queue<WorkItem> PQ;
-    int ctr = 0;
-    WorkItem *msg_queue;
-    unsigned long msg_loc_curr; 
-    unsigned long msg_loc = 0;
-    int rr = substrate::ThreadPool::getTID();
-    
-    /* PD */
-    int pd_counter = 0;
-    unsigned int latest_index = 0;
-  };
+  }
 
-  HDCPS_BR(const Indexer& x) : indexer(x) {
+  //! Called by the owner only.
+  bool try_pop(T& val) {
+    unsigned long pos = head.data.load(std::memory_order_relaxed);
+    Slot& s           = slot(pos);
+    if (s.seq.load(std::memory_order_acquire) != pos + 1)
+      return false;
+    val = s.val;
+    s.seq.store(pos + Size, std::memory_order_release);
+    head.data.store(pos + 1, std::memory_order_release);
+    return true;
+  }
 
+  //! Called by the owner only.
+  bool empty() const {
+    unsigned long pos = head.data.load(std::memory_order_relaxed);
+    return slot(pos).seq.load(std::memory_order_acquire) != pos + 1;
   }
 
-  ~HDCPS_BR() {
-    
+  //! Messages claimed by senders and not yet popped. Called by any thread.
+  unsigned long in_flight() const {
+    // head never passes tail, so read head first
+    unsigned long h = head.data.load(std::memory_order_acquire);
+    return tail.data.load(std::memory_order_acquire) - h;
   }
-  substrate::PerThreadStorage<ThreadData> data;
-  Indexer indexer;
+};
 
-  template <typename _T>
-  using retype = HDCPS_BR<_T, Indexer>;
+/**
+ * Tasks that travel together through one MessageRing slot. CAPACITY fills
+ * MSG_CHUNK_LINES cache lines together with the slot's sequence word.
+ */
+template <typename T>
+struct MessageChunk {
+  static const size_t BYTES =
+      MSG_CHUNK_LINES * sizeof(substrate::CacheLineStorage<char>) -
+      2 * sizeof(unsigned long);
+  static const unsigned CAPACITY =
+      BYTES / sizeof(T) > 0 ? BYTES / sizeof(T) : 1;
+
+  unsigned n = 0;
+  T items[CAPACITY];
+};
 
-  template <bool b>
-  using rethread = HDCPS_BR;
+/**
+ * Sender-side batching for HDCPS. Tasks for a receiver collect in a chunk
+ * that is sent once it holds chunk_size tasks. Partial chunks go out every
+ * flush_every operations of the sending thread, and always before it
+ * reports an empty pop, so buffered tasks never hide from termination.
+ * drain_budget bounds the tasks a receiver moves into its heap per call.
+ */
+struct MessageConfig {
+  unsigned chunk_size;
+  unsigned flush_every;
+  unsigned drain_budget;
+
+  MessageConfig(unsigned chunk_size = 0, unsigned flush_every = 64,
+                unsigned drain_budget = MSG_QUEUE_SIZE)
+      : chunk_size(chunk_size), flush_every(flush_every),
+        drain_budget(drain_budget) {}
+};
 
-  typedef T value_type;
+/**
+ * Receivers for the remote pushes of HDCPS. A thread walks the other threads
+ * on its own socket round-robin and sends cross_pct percent of its remote
+ * pushes, also round-robin, to threads on other sockets. Most messages then
+ * stay within the socket's L3, while high-priority work still spreads across
+ * the machine.
+ */
+class SocketPeers {
+  std::vector<std::vector<unsigned>> near;
+  std::vector<std::vector<unsigned>> far;
+  std::vector<unsigned> socket;
+  unsigned cross_pct;
 
-  void push(const value_type& val) {
-    
-    ThreadData& p = *data.getLocal();
-    if (p.msg_loc != p.msg_loc_curr) {
-        p.PQ.push(p.msg_queue[p.msg_loc]);
-        p.msg_loc = (p.msg_loc + 1) % MSG_QUEUE_SIZE;
+public:
+  //! Per-sender walk state, kept in the sender's ThreadData
+  struct Cursor {
+    unsigned near = 0;
+    unsigned far  = 0;
+    unsigned acc  = 0;
+    unsigned long cross_sends = 0;
+  };
+
+  explicit SocketPeers(unsigned cross_pct)
+      : near(runtime::activeThreads), far(runtime::activeThreads),
+        socket(runtime::activeThreads), cross_pct(std::min(cross_pct, 100u)) {
+    auto& tp = substrate::getThreadPool();
+    for (unsigned i = 0; i < runtime::activeThreads; ++i) {
+      socket[i] = tp.getSocket(i);
+      for (unsigned j = 0; j < runtime::activeThreads; ++j) {
+        if (i == j)
+          continue;
+        if (tp.getSocket(i) == tp.getSocket(j))
+          near[i].push_back(j);
+        else
+          far[i].push_back(j);
+      }
     }
-    
-    if (p.ctr <= dist_factor) {
-      p.PQ.push(WorkItem(val, indexer(val)));
+  }
+
+  //! Next receiver for tid; tid itself only when it is the sole thread
+  unsigned next(unsigned tid, Cursor& c) {
+    std::vector<unsigned>& nv = near[tid];
+    std::vector<unsigned>& fv = far[tid];
+    c.acc += cross_pct;
+    bool cross = c.acc >= 100;
+    if (cross)
+      c.acc -= 100;
+
+    if ((cross || nv.empty()) && !fv.empty()) {
+      c.far = (c.far + 1) % fv.size();
+      return fv[c.far];
     }
-    else {
-      p.rr = (p.rr + 1) % runtime::activeThreads;
-      if (p.rr == substrate::ThreadPool::getTID()) {p.PQ.push(WorkItem(val, indexer(val)));}
-      ThreadData& r = *data.getRemote(p.rr); 
-     
-      int loc = r.msg_loc_curr; r.msg_loc_curr = (r.msg_loc_curr + 1) % MSG_QUEUE_SIZE;
-      r.msg_queue[loc] = WorkItem(val, indexer(val)); 
-      
+    if (!nv.empty()) {
+      c.near = (c.near + 1) % nv.size();
+      return nv[c.near];
     }
-    
-    //p.ctr = (p.ctr + 1) % dist_factor_den;
-    
+    return tid;
   }
 
-  template <typename Iter>
-  void push(Iter b, Iter e) {
-    for (; b!=e; ++b) {
-      push(*b);
+  bool crosses(unsigned a, unsigned b) const { return socket[a] != socket[b]; }
+};
+
+/**
+ * Work stealing for HDCPS. A thread whose heap and message ring are both empty
+ * posts a request on one victim, picked at random or by walking its own
+ * socket first. The victim answers on its next push or pop by sending up to k
+ * of its top tasks (never more than half its heap) into the thief's ring, so
+ * heaps stay owner-only.
+ */
+struct StealConfig {
+  enum Victim { NONE, RANDOM, SOCKET };
+
+  Victim victim;
+  unsigned k;
+
+  StealConfig(Victim victim = NONE, unsigned k = 8) : victim(victim), k(k) {}
+};
+
+/*
+ * RELD and HDCPS are one worklist, CPSWorkList, built from compile-time
+ * policies:
+ *
+ *  - LocalQueue picks the per-thread heap (BulkPriorityQueue, DAryHeap, ...).
+ *  - Distribution picks how pushes reach other threads. RandomHeaps (RELD)
+ *    pushes into the locked heap of a random thread. MessagePassing (HDCPS)
+ *    keeps heaps owner-only and sends tasks through message rings, as often
+ *    as the task distribution factor allows.
+ *  - Priority picks how a task's priority is found. TraitPriority reads it
+ *    from the task through PriorityTraits; IndexedPriority stores the
+ *    Indexer result next to the task, for tasks whose priority lives in
+ *    mutable graph data.
+ *  - Drift picks whether priority drift is sampled. SampledDrift<Scale> feeds
+ *    drift * Scale to the distribution; NoDrift compiles the monitor out.
+ *
+ * Every policy call is resolved at compile time. RELD, RELD_BR, HDCPS and
+ * HDCPS_BR name the four original combinations.
+ */
+
+/**
+ * Tasks carry their own priority, read through PriorityTraits. Items are the
+ * tasks themselves and the Indexer is never called.
+ */
+struct TraitPriority {
+  template <typename T, typename Indexer>
+  struct apply {
+    typedef T Item;
+
+    static const char* suffix() { return ""; }
+    static const T& wrap(Indexer&, const T& val) { return val; }
+    static const T& value(const Item& item) { return item; }
+    //! Priority recorded by the drift monitor
+    static unsigned drift(const Item& item) {
+      return PriorityTraits<T>::get(item);
+    }
+    //! Priority compared by priority-aware distribution
+    static unsigned key(Indexer&, const Item& item) {
+      return PriorityTraits<T>::get(item);
     }
- 
+  };
+};
+
+//! Tasks are stored next to the Indexer value computed when they are pushed
+struct IndexedPriority {
+  template <typename T, typename Indexer>
+  struct apply {
+    struct Item {
+      T first;
+      unsigned dist;
+
+      Item(const T& N, unsigned W) : first(N), dist(W) {}
+      Item() : first(), dist(0) {}
+
+      friend bool operator<(const Item& left, const Item& right) {
+        return left.dist > right.dist;
+      }
+    };
+
+    static const char* suffix() { return "_BR"; }
+    static Item wrap(Indexer& x, const T& val) { return Item(val, x(val)); }
+    static const T& value(const Item& item) { return item.first; }
+    static unsigned drift(const Item& item) { return item.dist; }
+    static unsigned key(Indexer&, const Item& item) { return item.dist; }
+  };
+};
+
+//! Stand-in for DriftMonitor that never produces a sample
+struct NoDriftMonitor {
+  explicit NoDriftMonitor(unsigned = 0) {}
+  unsigned long get() const { return 0; }
+  void idle() {}
+  template <typename F>
+  bool record(unsigned, F&&) {
+    return false;
   }
+};
 
-  template <typename RangeTy>
-  void push_initial(const RangeTy& range) {
-    auto b = range.begin();
-    auto e = range.end();
-    ThreadData& p = *data.getLocal();
-    for (; b!=e; ++b) {
-      p.PQ.push(WorkItem(*b, indexer(*b)));
+template <unsigned Scale = 1>
+struct SampledDrift {
+  typedef DriftMonitor Monitor;
+  static const unsigned scale = Scale;
+};
+
+struct NoDrift {
+  typedef NoDriftMonitor Monitor;
+  static const unsigned scale = 1;
+};
+
+/**
+ * RELD distribution: every push locks the heap of a random thread, every pop
+ * locks the popping thread's own heap. A bulk push locks each receiving heap
+ * once.
+ */
+struct RandomHeaps {
+  template <typename Item, typename Queue, typename Keys, typename Indexer>
+  class engine : private boost::noncopyable {
+    using Lock_ty = galois::substrate::SimpleLock;
+
+    struct ThreadData {
+      Queue PQ;
+      Lock_ty m_mutex;
+      XorShift rng;
+      Outbox<Item> outbox;
+      //! Pushes into heaps on another NUMA node
+      unsigned long remote_node = 0;
+    };
+
+    substrate::PerThreadStorage<ThreadData> data;
+    std::string region;
+
+    /* PD */
+    unsigned long pd = 0;
+
+    ThreadData& local() {
+      ThreadData& p = *data.getLocal();
+      p.rng.seed(substrate::ThreadPool::getTID());
+      return p;
     }
-  }
-  
-  galois::optional<value_type> pop() { 
-    
-    ThreadData& p = *data.getLocal();
-   
-    unsigned long loc = p.msg_loc_curr;
 
-    if (p.msg_loc != loc) {
-        p.PQ.push(p.msg_queue[p.msg_loc]);
-        p.msg_loc = (p.msg_loc + 1) % MSG_QUEUE_SIZE;
+  public:
+    explicit engine(Indexer&) : region(std::string("RELD") + Keys::suffix()) {
+      onEachThread([this] { data.getLocal()->PQ.reserve(CPS_HEAP_RESERVE); });
     }
 
-    if (p.PQ.empty()) {
-        return galois::optional<value_type>();
+    ~engine() {
+      unsigned long remote = 0;
+      for (unsigned i = 0; i < runtime::activeThreads; ++i)
+        remote += data.getRemote(i)->remote_node;
+      runtime::reportStat_Single(region, "RemoteNodeAccesses", remote);
+      reportHeapPeak(region.c_str(), [this](unsigned i) {
+        return data.getRemote(i)->PQ.peak_bytes();
+      });
+      onEachThread([this] { data.getLocal()->PQ.reset(); });
     }
-    galois::optional<value_type> retval;
-   
-    {
-      if (substrate::ThreadPool::getTID() == 0) {
-        /* Priority drift logic */
-        if (p.pd_counter == 2000) {
-          sync = true;
-        }
-        if (p.pd_counter == 2100) {
-          sync = false;
-          p.pd_counter = 0;
-          
-          for (int i = 1; i <  runtime::activeThreads; i++) {
-            int pd_ = p.latest_index - data.getRemote(i)->latest_index;
-            pd += abs(pd_ * 4);
-          }
 
-          if (first_iter) {
-            pd_prev = pd;
-            first_iter = false;
-          }
-          else {
-            if (pd >= (pd_prev) && prev_decision == true) {
-              dist_factor = min(dist_factor + 1, 8000); // decrease TDF
-              prev_decision = false;
-            }
-            else if (pd >= (pd_prev) && prev_decision == false) {
-              dist_factor = max(dist_factor - 1, 3000); // increase tdf
-              prev_decision = true;
-            }
-            else {
-              dist_factor = min(dist_factor + 1, 8000); // decrease TDF
-              prev_decision = false;
-            }
-          }
-          std::cout << "PD " << pd << std::endl;
-          pd_prev = pd;
-          pd = 0;
-          
-        }
+    //! Drift sampling period in us
+    unsigned period() const { return 1000; }
+
+    void push(const Item& val) {
+      ThreadData& p = local();
+      unsigned tid  = substrate::ThreadPool::getTID();
+      unsigned dst  = p.rng.next() % runtime::activeThreads;
+      if (crossNode(tid, dst))
+        p.remote_node++;
+      ThreadData& r = *data.getRemote(dst);
+      r.m_mutex.lock();
+      r.PQ.push(val);
+      r.m_mutex.unlock();
+    }
+
+    template <typename Iter>
+    void push(Iter b, Iter e) {
+      ThreadData& p = local();
+      unsigned tid  = substrate::ThreadPool::getTID();
+      for (; b != e; ++b) {
+        p.outbox.add(p.rng.next() % runtime::activeThreads, *b);
       }
+      p.outbox.flush([&](unsigned dst, std::vector<Item>& batch) {
+        if (crossNode(tid, dst))
+          p.remote_node++;
+        ThreadData& r = *data.getRemote(dst);
+        r.m_mutex.lock();
+        r.PQ.push_bulk(batch.begin(), batch.end());
+        r.m_mutex.unlock();
+      });
     }
-    p.pd_counter++;
-    
-    /* PD */
-    if (sync == true) {
-      p.latest_index = p.PQ.top().dist;
+
+    galois::optional<Item> pop() {
+      ThreadData& p = *data.getLocal();
+      galois::optional<Item> retval;
+      p.m_mutex.lock();
+      if (!p.PQ.empty()) {
+        retval = p.PQ.top();
+        p.PQ.pop();
+      }
+      p.m_mutex.unlock();
+      return retval;
     }
-    
-    retval = p.PQ.top().first; p.PQ.pop();
-   
-    return retval;
-  }
+
+    void adapt(unsigned long drift) {
+      pd = (pd + drift) / 2;
+      std::cout << "PD " << pd << std::endl;
+    }
+  };
 };
-GALOIS_WLCOMPILECHECK(HDCPS_BR)
 
-/* */
-template <typename T, class Indexer = DummyIndexer<int>>
-class RELD_BR : private boost::noncopyable {
-/* Lock */
-using Lock_ty = galois::substrate::SimpleLock;
+/**
+ * HDCPS distribution. Heaps are owner-only; a push stays local while the
+ * per-thread counter is within the task distribution factor and otherwise
+ * goes to a SocketPeers receiver in a MessageChunk. Drift samples drive the
+ * factor through a TDFController. The template arguments are the default
+ * factor bounds: finer ones give the controller smaller steps.
+ */
+template <int Min = 3, int Max = 8, int Den = 10>
+struct MessagePassing {
+  static TDFConfig defaultTDF() { return TDFConfig(Min, Max, Den); }
+
+  template <typename Item, typename Queue, typename Keys, typename Indexer>
+  class engine : private boost::noncopyable {
+    typedef MessageChunk<Item> Chunk;
+
+    struct ThreadData {
+      Queue PQ;
+      int ctr = 0;
+      MessageRing<Chunk> msg_queue;
+      std::vector<Item> drain_buf;
+      std::vector<Item> local_buf;
+      SocketPeers::Cursor cursor;
+
+      /* Outgoing chunks, one per receiver */
+      std::vector<Chunk> chunks;
+      std::vector<unsigned> pending;
+      std::vector<bool> listed;
+      unsigned ops = 0;
+      unsigned long chunks_sent = 0;
+
+      //! Priority this thread is working on, read by priority-aware senders
+      std::atomic<unsigned> front{DriftMonitor::IDLE};
+
+      /* Work stealing */
+      struct StealSlot {
+        std::atomic<int> thief{-1};
+      };
+      //! Thread waiting for our work, written by thieves
+      substrate::CacheLineStorage<StealSlot> steal_req;
+      int steal_victim = -1;
+      SocketPeers::Cursor steal_cursor;
+      XorShift rng;
+      unsigned long steals = 0;
+      unsigned long stolen = 0;
+      //! Ring pushes and posted steal requests aimed at another NUMA node
+      unsigned long remote_node = 0;
+
+      /* Drain stats */
+      unsigned long drain_batches = 0;
+      unsigned long drained       = 0;
+      unsigned long drain_max     = 0;
+    };
+
+    std::unique_ptr<TDFController> tdf;
+    SocketPeers peers;
+    bool priority_aware;
+    StealConfig steal;
+    MessageConfig msg;
+    TDFConfig tdf_cfg;
+    Indexer& indexer;
+    std::string region;
+    substrate::PerThreadStorage<ThreadData> data;
+
+    //! Move pending chunks into the local heap, about drain_budget tasks' worth
+    void drain(ThreadData& p) {
+      Chunk c;
+      while (p.drain_buf.size() < msg.drain_budget &&
+             p.msg_queue.try_pop(c)) {
+        p.drain_buf.insert(p.drain_buf.end(), c.items, c.items + c.n);
+      }
+      if (p.drain_buf.empty()) {
+        return;
+      }
+      unsigned long n = p.drain_buf.size();
+      p.PQ.push_bulk(p.drain_buf.begin(), p.drain_buf.end());
+      p.drain_buf.clear();
+      p.drain_batches++;
+      p.drained += n;
+      p.drain_max = std::max(p.drain_max, n);
+    }
 
-bool sync = false;
-unsigned int pd = 0;
+    //! Set up the calling thread's ring and heap on its own NUMA node
+    void place(ThreadData& p) {
+      p.msg_queue.allocate();
+      p.PQ.reserve(CPS_HEAP_RESERVE);
+    }
 
+    //! Hand the top of our heap to a thread that asked for work
+    void serve_steal(ThreadData& p) {
+      std::atomic<int>& req = p.steal_req.data.thief;
+      if (req.load(std::memory_order_relaxed) < 0)
+        return;
+      int thief = req.exchange(-1, std::memory_order_acquire);
+      if (thief < 0)
+        return;
+      size_t k = std::min<size_t>(std::min<size_t>(steal.k, p.PQ.size() / 2),
+                                  Chunk::CAPACITY);
+      if (k == 0)
+        return;
+      Chunk c;
+      for (; c.n < k; ++c.n) {
+        c.items[c.n] = p.PQ.top();
+        p.PQ.pop();
+      }
+      if (crossNode(substrate::ThreadPool::getTID(), thief))
+        p.remote_node++;
+      if (data.getRemote(thief)->msg_queue.try_push(c)) {
+        p.steals++;
+        p.stolen += c.n;
+        p.chunks_sent++;
+      } else {
+        p.PQ.push_bulk(c.items, c.items + c.n);
+      }
+    }
 
-public:
+    //! Withdraw any unanswered request and ask a new victim for work
+    void request_steal(ThreadData& p, unsigned tid) {
+      if (p.steal_victim >= 0) {
+        int self = tid;
+        data.getRemote(p.steal_victim)
+            ->steal_req.data.thief.compare_exchange_strong(
+                self, -1, std::memory_order_relaxed);
+        p.steal_victim = -1;
+      }
 
-  struct WorkItem{
-    T first;
-    unsigned dist;
+      unsigned v;
+      if (steal.victim == StealConfig::RANDOM) {
+        p.rng.seed(tid);
+        v = p.rng.next() % runtime::activeThreads;
+      } else {
+        v = peers.next(tid, p.steal_cursor);
+      }
+      if (v == tid)
+        return;
+
+      int none = -1;
+      if (data.getRemote(v)->steal_req.data.thief.compare_exchange_strong(
+              none, (int)tid, std::memory_order_release,
+              std::memory_order_relaxed)) {
+        p.steal_victim = v;
+        if (crossNode(tid, v))
+          p.remote_node++;
+      }
+    }
 
-    WorkItem(const T& N, unsigned W): first(N), dist(W) {}
-    WorkItem(): first(), dist(0) {}
+    //! Send dst's chunk; if its ring is full the tasks stay local
+    void ship(ThreadData& p, unsigned tid, unsigned dst) {
+      Chunk& c    = p.chunks[dst];
+      bool remote = peers.crosses(tid, dst);
+      p.remote_node += remote;
+      if (data.getRemote(dst)->msg_queue.try_push(c)) {
+        p.chunks_sent++;
+        if (remote)
+          p.cursor.cross_sends += c.n;
+      } else {
+        p.PQ.push_bulk(c.items, c.items + c.n);
+      }
+      c.n = 0;
+    }
 
-    unsigned int operator() () const {
-      return dist;
+    //! Buffer a task for dst, sending the chunk once it is full
+    void send(ThreadData& p, unsigned tid, unsigned dst, const Item& val) {
+      if (p.chunks.size() < runtime::activeThreads) {
+        p.chunks.resize(runtime::activeThreads);
+        p.listed.resize(runtime::activeThreads);
+      }
+      Chunk& c = p.chunks[dst];
+      if (!p.listed[dst]) {
+        p.listed[dst] = true;
+        p.pending.push_back(dst);
+      }
+      c.items[c.n++] = val;
+      if (c.n >= msg.chunk_size)
+        ship(p, tid, dst);
     }
 
- 
-    friend bool operator<(const WorkItem& left,
-                          const WorkItem& right) {
-      return left.dist > right.dist;
+    //! Send every partly filled chunk
+    void flush(ThreadData& p, unsigned tid) {
+      for (unsigned dst : p.pending) {
+        if (p.chunks[dst].n)
+          ship(p, tid, dst);
+        p.listed[dst] = false;
+      }
+      p.pending.clear();
+      p.ops = 0;
     }
-  };
 
-  RELD_BR(const Indexer& x) : indexer(x) {
-    srand( (unsigned)time(NULL) );
-    
-  }
+    //! Bound how long a partial chunk waits for more tasks
+    void tick(ThreadData& p, unsigned tid) {
+      if (++p.ops >= msg.flush_every)
+        flush(p, tid);
+    }
 
-  ~RELD_BR() {
+    //! Is this task at least as urgent as anything in the local heap
+    bool urgent(ThreadData& p, unsigned key) {
+      return p.PQ.empty() || key <= Keys::key(indexer, p.PQ.top());
+    }
 
-  }
-  struct ThreadData {
-    priority_queue<WorkItem> PQ;
-    Lock_ty m_mutex;
-    int remote_thread;
+    //! Is dst working on something less urgent than this task
+    bool lagging(unsigned dst, unsigned key) {
+      return data.getRemote(dst)->front.load(std::memory_order_relaxed) > key;
+    }
+
+    //! Receiver for a new task; tid itself keeps it local
+    unsigned route(ThreadData& p, unsigned tid, const Item& val) {
+      unsigned key = priority_aware ? Keys::key(indexer, val) : 0;
+      unsigned dst = tid;
+      if (p.ctr > tdf->get() && (!priority_aware || urgent(p, key))) {
+        dst = peers.next(tid, p.cursor);
+        // The receiver is already ahead of this task: keep it
+        if (priority_aware && !lagging(dst, key))
+          dst = tid;
+      }
+      p.ctr = (p.ctr + 1) % tdf->den();
+      return dst;
+    }
+
+    //! Work that every push and pop does first
+    ThreadData& enter() {
+      ThreadData& p = *data.getLocal();
+      drain(p);
+      if (steal.victim != StealConfig::NONE)
+        serve_steal(p);
+      return p;
+    }
+
+  public:
+    engine(Indexer& x, const TDFConfig& tdf_cfg = defaultTDF(),
+           unsigned cross_socket_pct = 25,
+           const StealConfig& steal = StealConfig(),
+           const MessageConfig& msg = MessageConfig())
+        : tdf(TDFController::make(tdf_cfg)), peers(cross_socket_pct),
+          priority_aware(tdf_cfg.priority_aware), steal(steal), msg(msg),
+          tdf_cfg(tdf_cfg), indexer(x),
+          region(std::string("HDCPS") + Keys::suffix()) {
+      unsigned cap = Chunk::CAPACITY;
+      if (this->msg.chunk_size == 0 || this->msg.chunk_size > cap)
+        this->msg.chunk_size = cap;
+      if (this->msg.flush_every == 0)
+        this->msg.flush_every = 1;
+      onEachThread([this] { place(*data.getLocal()); });
+    }
+
+    ~engine() {
+      unsigned long batches = 0, drained = 0, max_batch = 0, cross = 0;
+      unsigned long steals = 0, stolen = 0, chunks = 0, remote = 0;
+      for (unsigned i = 0; i < runtime::activeThreads; ++i) {
+        ThreadData& r = *data.getRemote(i);
+        chunks += r.chunks_sent;
+        remote += r.remote_node;
+        cross += r.cursor.cross_sends;
+        steals += r.steals;
+        stolen += r.stolen;
+        batches += r.drain_batches;
+        drained += r.drained;
+        max_batch = std::max(max_batch, r.drain_max);
+      }
+      runtime::reportStat_Single(region, "DrainBatches", batches);
+      runtime::reportStat_Single(region, "DrainedMsgs", drained);
+      runtime::reportStat_Single(region, "MsgChunks", chunks);
+      runtime::reportStat_Single(region, "MaxDrainBatch", max_batch);
+      runtime::reportStat_Single(region, "CrossSocketMsgs", cross);
+      runtime::reportStat_Single(region, "Steals", steals);
+      runtime::reportStat_Single(region, "StolenTasks", stolen);
+      runtime::reportStat_Single(region, "RemoteNodeAccesses", remote);
+      runtime::reportStat_Single(region, "UndeliveredMsgs", in_flight());
+      reportHeapPeak(region.c_str(), [this](unsigned i) {
+        return data.getRemote(i)->PQ.peak_bytes();
+      });
+      onEachThread([this] { data.getLocal()->PQ.reset(); });
+    }
+
+    unsigned period() const { return tdf_cfg.period_us; }
+
+    /**
+     * Chunks sitting in message rings, including ones whose sender is still
+     * writing them. Zero once the loop has terminated.
+     */
+    unsigned long in_flight() {
+      unsigned long n = 0;
+      for (unsigned i = 0; i < runtime::activeThreads; ++i) {
+        n += data.getRemote(i)->msg_queue.in_flight();
+      }
+      return n;
+    }
+
+    void push(const Item& val) {
+      ThreadData& p = enter();
+      unsigned tid  = substrate::ThreadPool::getTID();
+      unsigned dst  = route(p, tid, val);
+      if (dst == tid)
+        p.PQ.push(val);
+      else
+        send(p, tid, dst, val);
+      tick(p, tid);
+    }
+
+    /**
+     * Route every task as push does and add the local share to the heap in
+     * one go. Remote tasks go through the same chunks as single pushes.
+     */
+    template <typename Iter>
+    void push(Iter b, Iter e) {
+      ThreadData& p = enter();
+      unsigned tid  = substrate::ThreadPool::getTID();
+      for (; b != e; ++b) {
+        const Item& val = *b;
+        unsigned dst    = route(p, tid, val);
+        if (dst == tid)
+          p.local_buf.push_back(val);
+        else
+          send(p, tid, dst, val);
+      }
+      p.PQ.push_bulk(p.local_buf.begin(), p.local_buf.end());
+      p.local_buf.clear();
+      tick(p, tid);
+    }
 
-    int pd_counter = 0;
-    unsigned int latest_index = 0;
+    galois::optional<Item> pop() {
+      ThreadData& p = *data.getLocal();
+      drain(p);
+
+      // A sender may have claimed a slot in our ring without publishing it
+      // yet. Wait for it instead of reporting empty, so that every thread
+      // popping nothing really means no task is left in flight.
+      while (p.PQ.empty() && p.msg_queue.in_flight()) {
+        substrate::asmPause();
+        drain(p);
+      }
+
+      // Nor may tasks wait in our own outgoing chunks
+      unsigned tid = substrate::ThreadPool::getTID();
+      if (p.PQ.empty())
+        flush(p, tid);
+      else
+        tick(p, tid);
+
+      if (p.PQ.empty()) {
+        if (priority_aware)
+          p.front.store(DriftMonitor::IDLE, std::memory_order_relaxed);
+        if (steal.victim != StealConfig::NONE)
+          request_steal(p, tid);
+        return galois::optional<Item>();
+      }
+      if (steal.victim != StealConfig::NONE)
+        serve_steal(p);
+
+      if (priority_aware)
+        p.front.store(Keys::key(indexer, p.PQ.top()),
+                      std::memory_order_relaxed);
+
+      galois::optional<Item> retval(p.PQ.top());
+      p.PQ.pop();
+      return retval;
+    }
+
+    void adapt(unsigned long drift) {
+      std::cout << "PD " << drift << std::endl;
+      tdf->update(drift);
+    }
   };
-  substrate::PerThreadStorage<ThreadData> data;
+};
+
+template <typename T, class Indexer, typename LocalQueue,
+          typename Distribution, typename Priority, typename Drift>
+class CPSWorkList : private boost::noncopyable {
+  typedef typename Priority::template apply<T, Indexer> Keys;
+  typedef typename Keys::Item Item;
+  typedef typename LocalQueue::template retype<Item> Queue;
+
   Indexer indexer;
+  typename Distribution::template engine<Item, Queue, Keys, Indexer> dist;
+  typename Drift::Monitor monitor;
+
+  //! Hands pushed ranges to the distribution as Items, by reference if T is
+  struct Wrap {
+    Indexer* x;
+    typedef decltype(Keys::wrap(std::declval<Indexer&>(),
+                                std::declval<const T&>())) result_type;
+    result_type operator()(const T& val) const { return Keys::wrap(*x, val); }
+  };
 
+public:
   template <typename _T>
-  using retype = RELD_BR<_T, Indexer>;
+  using retype =
+      CPSWorkList<_T, Indexer, typename LocalQueue::template retype<_T>,
+                  Distribution, Priority, Drift>;
 
   template <bool b>
-  using rethread = RELD_BR;
+  using rethread = CPSWorkList;
+
+  template <typename _lq>
+  struct with_local_queue {
+    typedef CPSWorkList<T, Indexer, _lq, Distribution, Priority, Drift> type;
+  };
 
   typedef T value_type;
 
-  void push(const value_type& val) {
+  CPSWorkList() : CPSWorkList(Indexer()) {}
 
-    ThreadData& p = *data.getLocal();
-    p.remote_thread = std::rand() % runtime::activeThreads;
-    if (p.remote_thread == substrate::ThreadPool::getTID()) {
-      p.m_mutex.lock();
-      p.PQ.push(WorkItem(val, indexer(val)));
-      p.m_mutex.unlock();
-    }
-    else {
-      ThreadData& r = *data.getRemote(p.remote_thread);
-      r.m_mutex.lock();
-      r.PQ.push(WorkItem(val, indexer(val)));
-      r.m_mutex.unlock();
-    }
+  //! Arguments after the indexer configure the distribution
+  template <typename... Args>
+  explicit CPSWorkList(const Indexer& x, Args&&... args)
+      : indexer(x), dist(indexer, std::forward<Args>(args)...),
+        monitor(dist.period()) {}
 
-  }
+  static TDFConfig defaultTDF() { return Distribution::defaultTDF(); }
+
+  //! Message chunks not yet received; only for MessagePassing
+  unsigned long in_flight() { return dist.in_flight(); }
+
+  void push(const value_type& val) { dist.push(Keys::wrap(indexer, val)); }
 
   template <typename Iter>
   void push(Iter b, Iter e) {
-    
-    for (; b!=e; ++b) {
-      push(*b);
-    }
-
+    Wrap w{&indexer};
+    dist.push(boost::make_transform_iterator(b, w),
+              boost::make_transform_iterator(e, w));
   }
 
+  //! Every thread pushes its own share of the initial range
   template <typename RangeTy>
   void push_initial(const RangeTy& range) {
-    auto b = range.begin();
-    auto e = range.end();
-    ThreadData& p = *data.getLocal();
-    for (; b!=e; ++b) {
-      p.m_mutex.lock();
-      p.PQ.push(WorkItem(*b, indexer(*b)));
-      p.m_mutex.unlock();
-    }
+    push(range.local_begin(), range.local_end());
   }
-  
-  galois::optional<value_type> pop() { 
-    
-    ThreadData& p = *data.getLocal();
-    p.m_mutex.lock();
-
-    if (p.PQ.empty()) {
-        p.m_mutex.unlock(); 
-        return galois::optional<value_type>();
-    }
-    
-    galois::optional<value_type> retval;
-    
-    /* PD */
-    if (sync == true) {
-      p.latest_index = p.PQ.top().dist;
-    }
 
-    retval = p.PQ.top().first; p.PQ.pop();
-    p.m_mutex.unlock();
-    
-    if (substrate::ThreadPool::getTID() == 0) {
-      int pd_temp = 0;
-      /* Priority drift logic */
-      if (p.pd_counter == 2000) {
-        sync = true;
-      }
-      if (p.pd_counter == 2100) {
-        sync = false;
-        p.pd_counter = 0;
-        
-        for (int i = 1; i <  runtime::activeThreads; i++) {
-          int pd_ = p.latest_index - data.getRemote(i)->latest_index;
-          pd_temp += abs(pd_);
-        } 
-        pd = (pd + pd_temp) / 2;
-        std::cout << "PD " << pd << std::endl;
-        
-      }
+  galois::optional<value_type> pop() {
+    galois::optional<Item> item = dist.pop();
+    if (!item) {
+      monitor.idle();
+      return galois::optional<value_type>();
     }
-    p.pd_counter++;
 
+    /* PD */
+    monitor.record(Keys::drift(*item), [&](unsigned long drift) {
+      dist.adapt(drift * Drift::scale);
+    });
 
-    return retval;
+    return galois::optional<value_type>(Keys::value(*item));
   }
 };
+
+template <typename T, typename LocalQueue = BulkPriorityQueue<T>>
+using RELD = CPSWorkList<T, DummyIndexer<int>, LocalQueue, RandomHeaps,
+                         TraitPriority, SampledDrift<64>>;
+GALOIS_WLCOMPILECHECK(RELD)
+
+template <typename T, class Indexer = DummyIndexer<int>,
+          typename LocalQueue = BulkPriorityQueue<T>>
+using RELD_BR = CPSWorkList<T, Indexer, LocalQueue, RandomHeaps,
+                            IndexedPriority, SampledDrift<1>>;
 GALOIS_WLCOMPILECHECK(RELD_BR)
 
+template <typename T, class Indexer = DummyIndexer<int>,
+          typename LocalQueue = BulkPriorityQueue<T>>
+using HDCPS = CPSWorkList<T, Indexer, LocalQueue, MessagePassing<3, 8, 10>,
+                          TraitPriority, SampledDrift<1>>;
+GALOIS_WLCOMPILECHECK(HDCPS)
+
+template <typename T, class Indexer = DummyIndexer<int>,
+          typename LocalQueue = BulkPriorityQueue<T>>
+using HDCPS_BR =
+    CPSWorkList<T, Indexer, LocalQueue, MessagePassing<3000, 8000, 10000>,
+                IndexedPriority, SampledDrift<4>>;
+GALOIS_WLCOMPILECHECK(HDCPS_BR)
+
 } // namespace worklists
 } // end namespace galois
 
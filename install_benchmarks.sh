@@ -13,6 +13,7 @@ export PMOD_DIR=$MAIN_DIR/PMOD/Galois-2.2.1/build/apps
 echo "${green}Copying Files${reset}"
 cp $MAIN_DIR/workloads/SSSP.cpp $GALOIS_HOME/lonestar/sssp
 cp $MAIN_DIR/workloads/BFS_SSSP.h $GALOIS_HOME/lonestar/include/Lonestar/
+cp $MAIN_DIR/workloads/CPSOptions.h $GALOIS_HOME/lonestar/include/Lonestar/
 cp $MAIN_DIR/workloads/SSSP_2.2.1.cpp $PMOD_HOME/apps/sssp/SSSP.cpp
 
 cp $MAIN_DIR/workloads/bfs_2.2.1.cpp $PMOD_HOME/apps/bfs/bfs.cpp
@@ -23,6 +24,18 @@ cp $MAIN_DIR/workloads/BoruvkaMerge.cpp $PMOD_HOME/apps/boruvka
 
 cp $MAIN_DIR/workloads/PageRank-push.cpp $GALOIS_HOME/lonestar/pagerank
 
+# Local priority queue microbenchmark, built next to sssp
+cp $MAIN_DIR/workloads/LocalQueueBench.cpp $GALOIS_HOME/lonestar/sssp
+grep -q LocalQueueBench $GALOIS_HOME/lonestar/sssp/CMakeLists.txt || echo "app(localqueue-bench LocalQueueBench.cpp)" >> $GALOIS_HOME/lonestar/sssp/CMakeLists.txt
+
+# HDCPS exactly-once stress check, built next to sssp
+cp $MAIN_DIR/workloads/HDCPSCheck.cpp $GALOIS_HOME/lonestar/sssp
+grep -q HDCPSCheck $GALOIS_HOME/lonestar/sssp/CMakeLists.txt || echo "app(hdcps-check HDCPSCheck.cpp)" >> $GALOIS_HOME/lonestar/sssp/CMakeLists.txt
+
+# PMOD exactly-once check, with and without unmerging, built next to sssp
+cp $MAIN_DIR/workloads/AdaptiveObimCheck.cpp $PMOD_HOME/apps/sssp
+grep -q AdaptiveObimCheck $PMOD_HOME/apps/sssp/CMakeLists.txt || echo "app(adap-obim-check AdaptiveObimCheck.cpp)" >> $PMOD_HOME/apps/sssp/CMakeLists.txt
+
 # Compile Galois
 echo "${green}Compiling SSSP${reset}"
 cd $GALOIS_DIR
@@ -0,0 +1,120 @@
+/** AdaptiveObim exactly-once check -*- C++ -*-
+ * @file
+ * @section License
+ *
+ * Galois, a framework to exploit amorphous data-parallelism in irregular
+ * programs.
+ *
+ * Copyright (C) 2013, The University of Texas at Austin. All rights reserved.
+ * UNIVERSITY EXPRESSLY DISCLAIMS ANY AND ALL WARRANTIES CONCERNING THIS
+ * SOFTWARE AND DOCUMENTATION, INCLUDING ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR ANY PARTICULAR PURPOSE, NON-INFRINGEMENT AND WARRANTIES OF
+ * PERFORMANCE, AND ANY WARRANTY THAT MIGHT OTHERWISE ARISE FROM COURSE OF
+ * DEALING OR USAGE OF TRADE.  NO WARRANTY IS EITHER EXPRESS OR IMPLIED WITH
+ * RESPECT TO THE USE OF THE SOFTWARE OR DOCUMENTATION. Under no circumstances
+ * shall University be liable for incidental, special, indirect, direct or
+ * consequential damages or loss of profits, interruption of business, or
+ * related expenses which may arise from use of Software or Documentation,
+ * including but not limited to those resulting from defects in Software and/or
+ * Documentation, or loss or inaccuracy of data of any kind.
+ *
+ * @section Description
+ *
+ * Pushes tagged tasks through AdaptiveOrderedByIntegerMetric, with and
+ * without unmerging, and checks that every task is popped exactly once.
+ */
+#include "Galois/Galois.h"
+#include "llvm/Support/CommandLine.h"
+#include "Lonestar/BoilerPlate.h"
+
+#include <atomic>
+#include <iostream>
+#include <vector>
+
+static const char* name = "AdaptiveObim Check";
+static const char* desc =
+  "Pushes tagged tasks through the adaptive OBIM, with and without "
+  "unmerging, and checks that each one is popped exactly once";
+static const char* url = "adaptive_obim_check";
+
+namespace cll = llvm::cl;
+static cll::opt<unsigned int> numTasks("tasks", cll::desc("Tasks to push (default value 65536)"), cll::init(65536));
+
+// The first half of the tasks have priorities far apart, so each bin gets
+// few pushes and delta grows (merging bins, and later retiring the bins of
+// the old delta). Each of them pushes one task of the second half into four
+// adjacent priorities. Those pops then keep coming from the same bin, which
+// is what makes the unmerging worklist lower delta again.
+static const unsigned int spread = 64;
+
+struct Task {
+  unsigned int tag;
+  unsigned int prio;
+
+  Task(unsigned int t, unsigned int p): tag(t), prio(p) { }
+  Task(): tag(0), prio(0) { }
+
+  unsigned int operator()() const { return prio; }
+};
+
+struct Indexer: public std::unary_function<Task, unsigned int> {
+  unsigned int operator()(const Task& t) const { return t.prio; }
+};
+
+typedef std::vector<std::atomic<unsigned int> > Counts;
+
+struct Process {
+  typedef int tt_does_not_need_aborts;
+
+  Counts& popped;
+  unsigned int half;
+  Process(Counts& p, unsigned int h): popped(p), half(h) { }
+
+  void operator()(Task& t, Galois::UserContext<Task>& ctx) const {
+    popped[t.tag].fetch_add(1, std::memory_order_relaxed);
+    if (t.tag < half)
+      ctx.push(Task(t.tag + half, half * spread + t.tag % 4));
+  }
+};
+
+template<typename WL>
+bool check(const char* wlname) {
+  unsigned int half = numTasks / 2;
+  Counts popped(2 * half);
+  for (auto& c : popped)
+    c.store(0, std::memory_order_relaxed);
+
+  std::vector<Task> initial;
+  for (unsigned int i = 0; i < half; ++i)
+    initial.push_back(Task(i, i * spread));
+  Galois::for_each(initial.begin(), initial.end(), Process(popped, half), Galois::wl<WL>());
+
+  unsigned long bad = 0;
+  for (unsigned int i = 0; i < popped.size(); ++i) {
+    unsigned int n = popped[i].load(std::memory_order_relaxed);
+    if (n != 1 && !bad++)
+      std::cerr << wlname << ": task " << i << " popped " << n << " times\n";
+  }
+  std::cout << wlname << ": " << popped.size() - bad << " of " << popped.size()
+            << " tasks popped exactly once\n";
+  return !bad;
+}
+
+int main(int argc, char **argv) {
+  Galois::StatManager statManager;
+  LonestarStart(argc, argv, name, desc, url);
+
+  using namespace Galois::WorkList;
+  typedef dChunkedFIFO<64> dChunk;
+  typedef AdaptiveOrderedByIntegerMetric<Indexer, dChunk, 0, true, false, 64, Task, unsigned int> ADAPOBIM;
+  typedef AdaptiveOrderedByIntegerMetric<Indexer, dChunk, 0, true, false, 64, Task, unsigned int, true, true> ADAPOBIM_UNMERGE;
+
+  bool ok = check<ADAPOBIM>("adap-obim");
+  ok = check<ADAPOBIM_UNMERGE>("adap-obim-unmerge") && ok;
+  if (!ok) {
+    std::cerr << "Verification failed.\n";
+    abort();
+  }
+  std::cout << "Verification successful.\n";
+  return 0;
+}
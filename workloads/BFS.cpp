@@ -29,6 +29,7 @@
 
 #include "Lonestar/BoilerPlate.h"
 #include "Lonestar/BFS_SSSP.h"
+#include "Lonestar/CPSOptions.h"
 
 #include <iostream>
 #include <cmath>
@@ -55,16 +56,13 @@ static cll::opt<unsigned int>
     stepShift("delta",
               cll::desc("Shift value for the deltastep (default value 13)"),
               cll::init(13));
-static cll::opt<unsigned int>
-    minCores("minCores",
-              cll::desc("Shift value for the deltastep (default value 13)"),
-              cll::init(4));
 enum Algo {
   deltaTile = 0,
   deltaStep,
   deltaStep_reld,
   deltaStep_hdcps,
   deltaStep_minn,
+  deltaStep_mq,
   serDeltaTile,
   serDelta,
   dijkstraTile,
@@ -73,7 +71,7 @@ enum Algo {
   topoTile
 };
 
-const char* const ALGO_NAMES[] = {"deltaTile", "deltaStep", "deltaStep_reld", "deltaStep_minn", "deltaStep_hdcps", "serDeltaTile",
+const char* const ALGO_NAMES[] = {"deltaTile", "deltaStep", "deltaStep_reld", "deltaStep_hdcps", "deltaStep_minn", "deltaStep_mq", "serDeltaTile",
                                   "serDelta",  "dijkstraTile", "dijkstra",
                                   "topo",      "topoTile"};
 
@@ -84,6 +82,7 @@ static cll::opt<Algo>
                      clEnumVal(deltaStep_reld, "deltaStep_reld"),
                      clEnumVal(deltaStep_minn, "deltaStep_minn"),
                      clEnumVal(deltaStep_hdcps, "deltaStep_hdcps"),
+                     clEnumVal(deltaStep_mq, "deltaStep_mq"),
                      clEnumVal(serDeltaTile, "serDeltaTile"),
                      clEnumVal(serDelta, "serDelta"),
                      clEnumVal(dijkstraTile, "dijkstraTile"),
@@ -250,7 +249,8 @@ void deltaStepAlgoMinn(Graph& graph, GNode source, const P& pushWrap,
                        }
                      }
                    },
-                   galois::wl<OBIM>(UpdateRequestIndexer{stepShift}, minCores),
+                   galois::wl<OBIM>(UpdateRequestIndexer{stepShift},
+                                    cps_options::minnowConfig()),
                    galois::no_conflicts(), galois::loopname("SSSP"));
 
   if (TRACK_WORK) {
@@ -262,7 +262,8 @@ void deltaStepAlgoMinn(Graph& graph, GNode source, const P& pushWrap,
   }
 }
 
-template <typename T, typename P, typename R>
+template <typename T, typename WL = galois::worklists::RELD<T>, typename P,
+          typename R>
 void deltaStepAlgoRELD(Graph& graph, GNode source, const P& pushWrap,
                    const R& edgeRange) {
 
@@ -271,9 +272,6 @@ void deltaStepAlgoRELD(Graph& graph, GNode source, const P& pushWrap,
   //! [reducible for self-defined stats]
   galois::GAccumulator<size_t> WLEmptyWork;
 
-  namespace gwl = galois::worklists;
-
-  using RELD = gwl::RELD<T>;
   graph.getData(source) = 0;
 
   galois::InsertBag<T> initBag;
@@ -322,7 +320,7 @@ void deltaStepAlgoRELD(Graph& graph, GNode source, const P& pushWrap,
                        }
                      }
                    },
-                   galois::wl<RELD>(),
+                   galois::wl<WL>(),
                    galois::no_conflicts(), galois::loopname("SSSP"));
 
   if (TRACK_WORK) {
@@ -396,7 +394,11 @@ void deltaStepAlgoHDCPS(Graph& graph, GNode source, const P& pushWrap,
                        }
                      }
                    },
-                   galois::wl<HDCPS>(UpdateRequestIndexer{stepShift}),
+                   galois::wl<HDCPS>(UpdateRequestIndexer{stepShift},
+                                     cps_options::tdfConfig(HDCPS::defaultTDF()),
+                                     cps_options::crossSocket,
+                                     cps_options::stealConfig(),
+                                     cps_options::messageConfig()),
                    galois::no_conflicts(), galois::loopname("SSSP"));
 
   if (TRACK_WORK) {
@@ -641,6 +643,12 @@ int main(int argc, char** argv) {
   case deltaStep_reld:
       deltaStepAlgoRELD<UpdateRequest>(graph, source, ReqPushWrap(),
                                  OutEdgeRangeFn{graph});
+      break;
+  case deltaStep_mq:
+      deltaStepAlgoRELD<UpdateRequest,
+                        galois::worklists::RELD_MQ<UpdateRequest>>(
+          graph, source, ReqPushWrap(), OutEdgeRangeFn{graph});
+      break;
   case deltaStep_minn:
       deltaStepAlgoMinn<UpdateRequest>(graph, source, ReqPushWrap(),
                                  OutEdgeRangeFn{graph});                                 
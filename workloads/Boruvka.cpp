@@ -27,6 +27,7 @@
 
 #include "llvm/Support/CommandLine.h"
 #include "Lonestar/BoilerPlate.h"
+#include "Lonestar/CPSOptions.h"
 
 #include <string>
 #include <sstream>
@@ -188,7 +189,12 @@ EdgeDataType runBodyParallel(Graph& graph) {
   else if (wl == "hdcps") {
     galois::for_each(
       galois::iterate(graph), process,
-      galois::wl<HDCPS_BR>(indexer), galois::loopname("Main")); 
+      galois::wl<HDCPS_BR>(indexer,
+                           cps_options::tdfConfig(HDCPS_BR::defaultTDF()),
+                           cps_options::crossSocket,
+                           cps_options::stealConfig(),
+                           cps_options::messageConfig()),
+      galois::loopname("Main"));
   }
   else if (wl == "minn") {
     galois::for_each(
@@ -0,0 +1,190 @@
+/*
+ * This file belongs to the Galois project, a C++ library for exploiting parallelism.
+ * The code is being released under the terms of the 3-Clause BSD License (a
+ * copy is located in LICENSE.txt at the top-level directory).
+ *
+ * Copyright (C) 2018, The University of Texas at Austin. All rights reserved.
+ * UNIVERSITY EXPRESSLY DISCLAIMS ANY AND ALL WARRANTIES CONCERNING THIS
+ * SOFTWARE AND DOCUMENTATION, INCLUDING ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR ANY PARTICULAR PURPOSE, NON-INFRINGEMENT AND WARRANTIES OF
+ * PERFORMANCE, AND ANY WARRANTY THAT MIGHT OTHERWISE ARISE FROM COURSE OF
+ * DEALING OR USAGE OF TRADE.  NO WARRANTY IS EITHER EXPRESS OR IMPLIED WITH
+ * RESPECT TO THE USE OF THE SOFTWARE OR DOCUMENTATION. Under no circumstances
+ * shall University be liable for incidental, special, indirect, direct or
+ * consequential damages or loss of profits, interruption of business, or
+ * related expenses which may arise from use of Software or Documentation,
+ * including but not limited to those resulting from defects in Software and/or
+ * Documentation, or loss or inaccuracy of data of any kind.
+ */
+
+#ifndef LONESTAR_CPS_OPTIONS_H
+#define LONESTAR_CPS_OPTIONS_H
+
+#include "galois/worklists/Obim.h"
+#include "galois/worklists/WorkListHelpers.h"
+#include "llvm/Support/CommandLine.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Command line options shared by the apps that run the HD-CPS worklists.
+// Options that are not given keep the worklist's own default, so the bounds
+// of HDCPS (out of 10) and HDCPS_BR (out of 10000) both work unchanged.
+
+namespace cps_options {
+
+namespace cll = llvm::cl;
+using galois::worklists::MessageConfig;
+using galois::worklists::MinnowConfig;
+using galois::worklists::StealConfig;
+using galois::worklists::TDFConfig;
+
+static cll::opt<TDFConfig::Policy> tdfPolicy(
+    "tdfPolicy", cll::desc("HD-CPS task distribution factor controller:"),
+    cll::values(clEnumValN(TDFConfig::HILL_CLIMB, "hillclimb",
+                           "Hill-climb on drift (default)"),
+                clEnumValN(TDFConfig::PID, "pid", "PID on drift"),
+                clEnumValN(TDFConfig::FIXED, "fixed", "Fixed at -tdfInit"),
+                clEnumValEnd),
+    cll::init(TDFConfig::HILL_CLIMB));
+static cll::opt<int> tdfMin("tdfMin", cll::desc("Lower bound of the TDF"));
+static cll::opt<int> tdfMax("tdfMax", cll::desc("Upper bound of the TDF"));
+static cll::opt<int> tdfStep("tdfStep",
+                             cll::desc("Hill-climb step (default value 1)"));
+static cll::opt<int>
+    tdfInit("tdfInit", cll::desc("Initial TDF (default value -tdfMax)"));
+static cll::opt<int> tdfDen("tdfDen",
+                            cll::desc("Pushes per TDF distribution round"));
+static cll::opt<unsigned int>
+    tdfPeriod("tdfPeriod",
+              cll::desc("Drift sampling period in us (default value 1000)"));
+static cll::opt<double> tdfKp("tdfKp", cll::desc("PID proportional gain"));
+static cll::opt<double> tdfKi("tdfKi", cll::desc("PID integral gain"));
+static cll::opt<double> tdfKd("tdfKd", cll::desc("PID derivative gain"));
+static cll::opt<unsigned int>
+    tdfTarget("tdfTarget", cll::desc("Drift the PID controller steers to"));
+static cll::opt<unsigned int> crossSocket(
+    "crossSocket",
+    cll::desc("Percent of HD-CPS remote pushes sent to other sockets "
+              "(default value 25)"),
+    cll::init(25));
+static cll::opt<bool> priorityDist(
+    "priorityDist",
+    cll::desc("HD-CPS sends only tasks more urgent than the local heap top, "
+              "to threads working on less urgent ones"),
+    cll::init(false));
+static cll::opt<StealConfig::Victim> steal(
+    "steal", cll::desc("HD-CPS work stealing when a thread runs dry:"),
+    cll::values(clEnumValN(StealConfig::NONE, "none", "No stealing (default)"),
+                clEnumValN(StealConfig::RANDOM, "random", "Random victim"),
+                clEnumValN(StealConfig::SOCKET, "socket",
+                           "Victims on the same socket first"),
+                clEnumValEnd),
+    cll::init(StealConfig::NONE));
+static cll::opt<unsigned int>
+    stealK("stealK", cll::desc("Tasks taken per steal (default value 8)"),
+           cll::init(8));
+static cll::opt<unsigned int> msgChunk(
+    "msgChunk",
+    cll::desc("Tasks per HD-CPS message chunk (default value 0, as many as "
+              "fit in the chunk's cache lines)"),
+    cll::init(0));
+static cll::opt<unsigned int> msgFlush(
+    "msgFlush",
+    cll::desc("Worklist operations between flushes of partly filled HD-CPS "
+              "message chunks (default value 64)"),
+    cll::init(64));
+static cll::opt<bool>
+    tdfLog("tdfLog", cll::desc("Log every TDF decision (default false)"),
+           cll::init(false));
+static cll::opt<unsigned int> minCores(
+    "minCores", cll::desc("Minnow helper threads (default value one per "
+                          "-minnowRatio workers)"));
+static cll::opt<unsigned int> minnowRatio(
+    "minnowRatio",
+    cll::desc("Workers per Minnow helper when -minCores is not given "
+              "(default value 4)"),
+    cll::init(4));
+static cll::opt<MinnowConfig::Placement> minnowPlace(
+    "minnowPlace", cll::desc("Minnow helper placement:"),
+    cll::values(clEnumValN(MinnowConfig::LAST, "last",
+                           "Last threads help, contiguous worker groups "
+                           "(default)"),
+                clEnumValN(MinnowConfig::SOCKET, "socket",
+                           "Helpers on every socket, serving that socket"),
+                clEnumValN(MinnowConfig::SMT, "smt",
+                           "Helpers on the second hardware context of their "
+                           "worker's core"),
+                clEnumValN(MinnowConfig::MAP, "map", "As given by -minnowMap"),
+                clEnumValEnd),
+    cll::init(MinnowConfig::LAST));
+static cll::opt<std::string> minnowMap(
+    "minnowMap",
+    cll::desc("Helper of every thread for -minnowPlace=map, comma separated: "
+              "h marks a helper, a thread id names the helper serving it"));
+
+//! Overlay the options given on the command line on a worklist's defaults
+inline TDFConfig tdfConfig(TDFConfig cfg) {
+  cfg.policy = tdfPolicy;
+  cfg.log    = tdfLog;
+  cfg.priority_aware = priorityDist;
+  if (tdfMin.getNumOccurrences())
+    cfg.min = tdfMin;
+  if (tdfMax.getNumOccurrences())
+    cfg.max = tdfMax;
+  cfg.init = cfg.max;
+  if (tdfStep.getNumOccurrences())
+    cfg.step = tdfStep;
+  if (tdfInit.getNumOccurrences())
+    cfg.init = tdfInit;
+  if (tdfDen.getNumOccurrences())
+    cfg.den = tdfDen;
+  if (tdfPeriod.getNumOccurrences())
+    cfg.period_us = tdfPeriod;
+  if (tdfKp.getNumOccurrences())
+    cfg.kp = tdfKp;
+  if (tdfKi.getNumOccurrences())
+    cfg.ki = tdfKi;
+  if (tdfKd.getNumOccurrences())
+    cfg.kd = tdfKd;
+  if (tdfTarget.getNumOccurrences())
+    cfg.target = tdfTarget;
+
+  if (cfg.den <= 0 || cfg.min > cfg.max) {
+    std::cerr << "invalid TDF bounds: " << cfg.min << ".." << cfg.max << "/"
+              << cfg.den << "\n";
+    abort();
+  }
+  return cfg;
+}
+
+inline StealConfig stealConfig() { return StealConfig(steal, stealK); }
+
+inline MessageConfig messageConfig() {
+  return MessageConfig(msgChunk, msgFlush);
+}
+
+inline MinnowConfig minnowConfig() {
+  std::vector<int> map;
+  std::istringstream in(minnowMap);
+  for (std::string e; std::getline(in, e, ',');) {
+    char* end;
+    long t = strtol(e.c_str(), &end, 10);
+    if (e == "h") {
+      map.push_back(-1);
+    } else if (!e.empty() && *end == 0 && t >= 0) {
+      map.push_back(t);
+    } else {
+      std::cerr << "invalid -minnowMap entry: " << e << "\n";
+      abort();
+    }
+  }
+  return MinnowConfig(minCores, minnowPlace, minnowRatio, map);
+}
+
+} // namespace cps_options
+
+#endif
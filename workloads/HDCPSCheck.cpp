@@ -0,0 +1,174 @@
+/*
+ * This file belongs to the Galois project, a C++ library for exploiting parallelism.
+ * The code is being released under the terms of the 3-Clause BSD License (a
+ * copy is located in LICENSE.txt at the top-level directory).
+ *
+ * Copyright (C) 2018, The University of Texas at Austin. All rights reserved.
+ * UNIVERSITY EXPRESSLY DISCLAIMS ANY AND ALL WARRANTIES CONCERNING THIS
+ * SOFTWARE AND DOCUMENTATION, INCLUDING ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR ANY PARTICULAR PURPOSE, NON-INFRINGEMENT AND WARRANTIES OF
+ * PERFORMANCE, AND ANY WARRANTY THAT MIGHT OTHERWISE ARISE FROM COURSE OF
+ * DEALING OR USAGE OF TRADE.  NO WARRANTY IS EITHER EXPRESS OR IMPLIED WITH
+ * RESPECT TO THE USE OF THE SOFTWARE OR DOCUMENTATION. Under no circumstances
+ * shall University be liable for incidental, special, indirect, direct or
+ * consequential damages or loss of profits, interruption of business, or
+ * related expenses which may arise from use of Software or Documentation,
+ * including but not limited to those resulting from defects in Software and/or
+ * Documentation, or loss or inaccuracy of data of any kind.
+ */
+
+#include "galois/Galois.h"
+#include "galois/Timer.h"
+#include "galois/worklists/Obim.h"
+#include "galois/worklists/WorkListHelpers.h"
+#include "llvm/Support/CommandLine.h"
+
+#include "Lonestar/BoilerPlate.h"
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <utility>
+#include <vector>
+namespace cll = llvm::cl;
+
+// Every thread pushes tagged tasks into HDCPS and HDCPS_BR and pops them
+// again, with work stealing, small message chunks and priority-aware
+// distribution all on. Each first-half task pushes one task of the second
+// half when it is popped, so pushes keep coming from every thread while
+// others drain. The new task is twice as urgent as its parent, so
+// priority-aware distribution sends many of them to other threads. The check
+// fails unless each tag is popped exactly once and no message chunk is left
+// in a ring once the threads have stopped.
+//
+// The same tasks then go through the Minnow OBIM with one helper per worker,
+// so every push and pop crosses a worker's enqueue or dequeue ring.
+
+static const char* name = "HDCPS Exactly-Once Check";
+static const char* desc =
+    "Pushes tagged tasks from every thread through HDCPS, HDCPS_BR and the "
+    "Minnow OBIM and checks that each one is popped exactly once";
+static const char* url = "hdcps_check";
+
+static cll::opt<unsigned int>
+    numTasks("tasks", cll::desc("Tasks to push (default value 2097152)"),
+             cll::init(1u << 21));
+
+struct Task {
+  uint32_t tag;
+  uint32_t dist;
+
+  Task(uint32_t t, uint32_t d) : tag(t), dist(d) {}
+  Task() : tag(0), dist(0) {}
+};
+
+struct TaskIndexer {
+  unsigned int operator()(const Task& t) const { return t.dist; }
+};
+
+//! One thread's share of the first half, handed to push_initial as a loop
+//! would; a Minnow helper may not push() but files its share there.
+struct Seeds {
+  typedef std::vector<Task>::const_iterator iterator;
+  std::vector<Task> tasks;
+
+  iterator local_begin() const { return tasks.begin(); }
+  iterator local_end() const { return tasks.end(); }
+  std::pair<iterator, iterator> local_pair() const {
+    return std::make_pair(local_begin(), local_end());
+  }
+};
+
+template <typename WL>
+bool check(const char* wlname, WL& wl) {
+  const uint32_t half = numTasks / 2;
+  std::vector<std::atomic<uint32_t>> popped(2 * half);
+  for (auto& c : popped)
+    c.store(0, std::memory_order_relaxed);
+  // tasks pushed or still to be pushed that nobody has popped yet
+  std::atomic<int64_t> outstanding(half);
+
+  galois::Timer T;
+  T.start();
+  galois::on_each([&](const unsigned tid, const unsigned numT) {
+    Seeds seeds;
+    for (uint32_t i = tid; i < half; i += numT)
+      seeds.tasks.push_back(Task(i, (i * 2654435761u) >> 20));
+    wl.push_initial(seeds);
+
+    while (true) {
+      galois::optional<Task> t = wl.pop();
+      if (!t) {
+        if (outstanding.load() == 0)
+          break;
+        continue;
+      }
+      popped[t->tag].fetch_add(1, std::memory_order_relaxed);
+      if (t->tag < half) {
+        outstanding.fetch_add(1);
+        wl.push(Task(t->tag + half, t->dist / 2));
+      }
+      outstanding.fetch_sub(1);
+    }
+  });
+  T.stop();
+
+  unsigned long bad = 0;
+  for (uint32_t i = 0; i < popped.size(); ++i) {
+    uint32_t n = popped[i].load(std::memory_order_relaxed);
+    if (n != 1 && !bad++)
+      std::cerr << wlname << ": task " << i << " popped " << n << " times\n";
+  }
+  std::cout << wlname << ": " << popped.size() - bad << " of "
+            << popped.size() << " tasks popped exactly once, " << T.get()
+            << " msec" << std::endl;
+  return !bad;
+}
+
+template <typename WL>
+bool delivered(const char* wlname, WL& wl) {
+  unsigned long undelivered = wl.in_flight();
+  std::cout << wlname << ": " << undelivered << " undelivered message chunks"
+            << std::endl;
+  return !undelivered;
+}
+
+int main(int argc, char** argv) {
+  galois::SharedMemSys G;
+  LonestarStart(argc, argv, name, desc, url);
+
+  namespace gwl = galois::worklists;
+  using HDCPS    = gwl::HDCPS<Task, TaskIndexer>;
+  using HDCPS_BR = gwl::HDCPS_BR<Task, TaskIndexer>;
+
+  gwl::MessageConfig msg(4, 16);
+  bool ok = true;
+  {
+    gwl::TDFConfig tdf = HDCPS::defaultTDF();
+    tdf.priority_aware = true;
+    HDCPS wl(TaskIndexer(), tdf, 25,
+             gwl::StealConfig(gwl::StealConfig::SOCKET, 8), msg);
+    ok = check("HDCPS", wl) && delivered("HDCPS", wl) && ok;
+  }
+  {
+    gwl::TDFConfig tdf = HDCPS_BR::defaultTDF();
+    tdf.priority_aware = true;
+    HDCPS_BR wl(TaskIndexer(), tdf, 25,
+                gwl::StealConfig(gwl::StealConfig::RANDOM, 8), msg);
+    ok = check("HDCPS_BR", wl) && delivered("HDCPS_BR", wl) && ok;
+  }
+  {
+    using Minn = gwl::OrderedByIntegerMetricMinn<
+        TaskIndexer, gwl::PerSocketChunkFIFO<64>>::retype<Task>;
+    Minn wl(TaskIndexer(),
+            gwl::MinnowConfig(0, gwl::MinnowConfig::LAST, 1));
+    ok = check("Minnow", wl) && ok;
+  }
+
+  if (!ok) {
+    std::cerr << "Verification failed.\n";
+    abort();
+  }
+  std::cout << "Verification successful.\n";
+  return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * This file belongs to the Galois project, a C++ library for exploiting parallelism.
+ * The code is being released under the terms of the 3-Clause BSD License (a
+ * copy is located in LICENSE.txt at the top-level directory).
+ *
+ * Copyright (C) 2018, The University of Texas at Austin. All rights reserved.
+ * UNIVERSITY EXPRESSLY DISCLAIMS ANY AND ALL WARRANTIES CONCERNING THIS
+ * SOFTWARE AND DOCUMENTATION, INCLUDING ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR ANY PARTICULAR PURPOSE, NON-INFRINGEMENT AND WARRANTIES OF
+ * PERFORMANCE, AND ANY WARRANTY THAT MIGHT OTHERWISE ARISE FROM COURSE OF
+ * DEALING OR USAGE OF TRADE.  NO WARRANTY IS EITHER EXPRESS OR IMPLIED WITH
+ * RESPECT TO THE USE OF THE SOFTWARE OR DOCUMENTATION. Under no circumstances
+ * shall University be liable for incidental, special, indirect, direct or
+ * consequential damages or loss of profits, interruption of business, or
+ * related expenses which may arise from use of Software or Documentation,
+ * including but not limited to those resulting from defects in Software and/or
+ * Documentation, or loss or inaccuracy of data of any kind.
+ */
+
+#include "galois/Galois.h"
+#include "galois/Timer.h"
+#include "galois/graphs/LCGraph.h"
+#include "galois/worklists/WorkListHelpers.h"
+#include "llvm/Support/CommandLine.h"
+
+#include "Lonestar/BoilerPlate.h"
+#include "Lonestar/BFS_SSSP.h"
+
+#include <iostream>
+#include <queue>
+namespace cll = llvm::cl;
+
+// Serial Dijkstra driven by each of the local priority queues the CPS
+// worklists (RELD, HDCPS) can be instantiated with. The access pattern is the
+// one a single HDCPS thread sees on SSSP, so pops/sec here is a direct
+// comparison of the local queue cost.
+
+static const char* name = "CPS Local Queue Microbenchmark";
+static const char* desc =
+    "Runs serial Dijkstra with std::priority_queue and each CPS local queue "
+    "and reports pops/sec";
+static const char* url = "single_source_shortest_path";
+
+static cll::opt<std::string>
+    filename(cll::Positional, cll::desc("<input graph>"), cll::Required);
+
+static cll::opt<unsigned int>
+    startNode("startNode",
+              cll::desc("Node to start search from (default value 0)"),
+              cll::init(0));
+static cll::opt<unsigned int>
+    rounds("rounds", cll::desc("Runs per queue (default value 3)"),
+           cll::init(3));
+
+using Graph = galois::graphs::LC_CSR_Graph<std::atomic<uint32_t>, uint32_t>::
+    with_no_lockable<true>::type ::with_numa_alloc<true>::type;
+typedef Graph::GraphNode GNode;
+
+using SSSP          = BFS_SSSP<Graph, uint32_t, true>;
+using Dist          = SSSP::Dist;
+using UpdateRequest = SSSP::UpdateRequest;
+
+template <typename Q>
+void benchQueue(Graph& graph, GNode source, const char* qname) {
+  double best = 0;
+
+  for (unsigned r = 0; r < rounds; ++r) {
+    galois::do_all(galois::iterate(graph), [&graph](GNode n) {
+      graph.getData(n) = SSSP::DIST_INFINITY;
+    });
+    graph.getData(source) = 0;
+
+    Q wl;
+    wl.push(UpdateRequest(source, 0));
+    size_t pops = 0;
+
+    galois::Timer T;
+    T.start();
+    while (!wl.empty()) {
+      UpdateRequest item = wl.top();
+      wl.pop();
+      ++pops;
+
+      if (graph.getData(item.src) < item.dist) {
+        continue;
+      }
+
+      for (auto e : graph.edges(item.src)) {
+        GNode dst          = graph.getEdgeDst(e);
+        auto& ddata        = graph.getData(dst);
+        const Dist newDist = item.dist + graph.getEdgeData(e);
+
+        if (newDist < ddata) {
+          ddata = newDist;
+          wl.push(UpdateRequest(dst, newDist));
+        }
+      }
+    }
+    T.stop();
+
+    double rate = (double)pops / ((double)T.get_usec() / 1e6);
+    best        = std::max(best, rate);
+    std::cout << qname << ": " << pops << " pops in " << T.get() << "msec"
+              << std::endl;
+  }
+
+  std::cout << qname << " pops/sec: " << (size_t)best << std::endl;
+  galois::runtime::reportStat_Single("LocalQueueBench", qname, (size_t)best);
+}
+
+int main(int argc, char** argv) {
+  galois::SharedMemSys G;
+  LonestarStart(argc, argv, name, desc, url);
+
+  Graph graph;
+
+  std::cout << "Reading from file: " << filename << std::endl;
+  galois::graphs::readGraph(graph, filename);
+  std::cout << "Read " << graph.size() << " nodes, " << graph.sizeEdges()
+            << " edges" << std::endl;
+
+  if (startNode >= graph.size()) {
+    std::cerr << "failed to set source: " << startNode << "\n";
+    abort();
+  }
+
+  auto it = graph.begin();
+  std::advance(it, startNode);
+  GNode source = *it;
+
+  namespace gwl = galois::worklists;
+  benchQueue<std::priority_queue<UpdateRequest>>(graph, source,
+                                                 "std::priority_queue");
+  benchQueue<gwl::BulkPriorityQueue<UpdateRequest>>(graph, source,
+                                                    "BulkPriorityQueue");
+  benchQueue<gwl::DAryHeap<UpdateRequest, 4>>(graph, source, "DAryHeap<4>");
+  benchQueue<gwl::DAryHeap<UpdateRequest, 8>>(graph, source, "DAryHeap<8>");
+  benchQueue<gwl::MonotoneRadixHeap<UpdateRequest>>(graph, source,
+                                                    "MonotoneRadixHeap");
+
+  return 0;
+}
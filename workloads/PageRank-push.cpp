@@ -18,6 +18,7 @@
  */
 
 #include "Lonestar/BoilerPlate.h"
+#include "Lonestar/CPSOptions.h"
 #include "PageRank-constants.h"
 #include "galois/Bag.h"
 #include "galois/Galois.h"
@@ -120,7 +121,12 @@ void asyncPageRank(Graph& graph) {
     galois::for_each(
         galois::iterate(graph), process,
         galois::loopname("PushResidualAsync"),
-        galois::no_stats(), galois::wl<HDCPS_BR>(indexer));
+        galois::no_stats(),
+        galois::wl<HDCPS_BR>(indexer,
+                             cps_options::tdfConfig(HDCPS_BR::defaultTDF()),
+                             cps_options::crossSocket,
+                             cps_options::stealConfig(),
+                             cps_options::messageConfig()));
   }
   else if (worklistname == "reld") {
     galois::for_each(
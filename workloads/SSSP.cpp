@@ -29,6 +29,7 @@
 
 #include "Lonestar/BoilerPlate.h"
 #include "Lonestar/BFS_SSSP.h"
+#include "Lonestar/CPSOptions.h"
 
 #include <iostream>
 #include <cmath>
@@ -55,16 +56,16 @@ static cll::opt<unsigned int>
     stepShift("delta",
               cll::desc("Shift value for the deltastep (default value 13)"),
               cll::init(13));
-static cll::opt<unsigned int>
-    minCores("minCores",
-              cll::desc("Shift value for the deltastep (default value 13)"),
-              cll::init(4));
 enum Algo {
   deltaTile = 0,
   deltaStep,
   deltaStep_reld,
   deltaStep_hdcps,
   deltaStep_minn,
+  deltaStep_mq,
+  deltaTile_hdcps,
+  deltaTile_reld,
+  deltaTile_minn,
   serDeltaTile,
   serDelta,
   dijkstraTile,
@@ -73,7 +74,8 @@ enum Algo {
   topoTile
 };
 
-const char* const ALGO_NAMES[] = {"deltaTile", "deltaStep", "deltaStep_reld", "deltaStep_minn", "deltaStep_hdcps", "serDeltaTile",
+const char* const ALGO_NAMES[] = {"deltaTile", "deltaStep", "deltaStep_reld", "deltaStep_hdcps", "deltaStep_minn", "deltaStep_mq",
+                                  "deltaTile_hdcps", "deltaTile_reld", "deltaTile_minn", "serDeltaTile",
                                   "serDelta",  "dijkstraTile", "dijkstra",
                                   "topo",      "topoTile"};
 
@@ -84,6 +86,10 @@ static cll::opt<Algo>
                      clEnumVal(deltaStep_reld, "deltaStep_reld"),
                      clEnumVal(deltaStep_minn, "deltaStep_minn"),
                      clEnumVal(deltaStep_hdcps, "deltaStep_hdcps"),
+                     clEnumVal(deltaStep_mq, "deltaStep_mq"),
+                     clEnumVal(deltaTile_hdcps, "deltaTile_hdcps"),
+                     clEnumVal(deltaTile_reld, "deltaTile_reld"),
+                     clEnumVal(deltaTile_minn, "deltaTile_minn"),
                      clEnumVal(serDeltaTile, "serDeltaTile"),
                      clEnumVal(serDelta, "serDelta"),
                      clEnumVal(dijkstraTile, "dijkstraTile"),
@@ -250,7 +256,8 @@ void deltaStepAlgoMinn(Graph& graph, GNode source, const P& pushWrap,
                        }
                      }
                    },
-                   galois::wl<OBIM>(UpdateRequestIndexer{stepShift}, minCores),
+                   galois::wl<OBIM>(UpdateRequestIndexer{stepShift},
+                                    cps_options::minnowConfig()),
                    galois::no_conflicts(), galois::loopname("SSSP"));
 
   if (TRACK_WORK) {
@@ -262,7 +269,8 @@ void deltaStepAlgoMinn(Graph& graph, GNode source, const P& pushWrap,
   }
 }
 
-template <typename T, typename P, typename R>
+template <typename T, typename WL = galois::worklists::RELD<T>, typename P,
+          typename R>
 void deltaStepAlgoRELD(Graph& graph, GNode source, const P& pushWrap,
                    const R& edgeRange) {
 
@@ -271,9 +279,6 @@ void deltaStepAlgoRELD(Graph& graph, GNode source, const P& pushWrap,
   //! [reducible for self-defined stats]
   galois::GAccumulator<size_t> WLEmptyWork;
 
-  namespace gwl = galois::worklists;
-
-  using RELD = gwl::RELD<T>;
   graph.getData(source) = 0;
 
   galois::InsertBag<T> initBag;
@@ -322,7 +327,7 @@ void deltaStepAlgoRELD(Graph& graph, GNode source, const P& pushWrap,
                        }
                      }
                    },
-                   galois::wl<RELD>(),
+                   galois::wl<WL>(),
                    galois::no_conflicts(), galois::loopname("SSSP"));
 
   if (TRACK_WORK) {
@@ -396,7 +401,11 @@ void deltaStepAlgoHDCPS(Graph& graph, GNode source, const P& pushWrap,
                        }
                      }
                    },
-                   galois::wl<HDCPS>(UpdateRequestIndexer{stepShift}),
+                   galois::wl<HDCPS>(UpdateRequestIndexer{stepShift},
+                                     cps_options::tdfConfig(HDCPS::defaultTDF()),
+                                     cps_options::crossSocket,
+                                     cps_options::stealConfig(),
+                                     cps_options::messageConfig()),
                    galois::no_conflicts(), galois::loopname("SSSP"));
 
   if (TRACK_WORK) {
@@ -641,6 +650,12 @@ int main(int argc, char** argv) {
   case deltaStep_reld:
       deltaStepAlgoRELD<UpdateRequest>(graph, source, ReqPushWrap(),
                                  OutEdgeRangeFn{graph});
+      break;
+  case deltaStep_mq:
+      deltaStepAlgoRELD<UpdateRequest,
+                        galois::worklists::RELD_MQ<UpdateRequest>>(
+          graph, source, ReqPushWrap(), OutEdgeRangeFn{graph});
+      break;
   case deltaStep_minn:
       deltaStepAlgoMinn<UpdateRequest>(graph, source, ReqPushWrap(),
                                  OutEdgeRangeFn{graph});                                 
@@ -649,6 +664,22 @@ int main(int argc, char** argv) {
       deltaStepAlgoHDCPS<UpdateRequest>(graph, source, ReqPushWrap(),
                                  OutEdgeRangeFn{graph});
       break;  
+  // Edge tiles of high-degree vertices spread over threads like any task
+  case deltaTile_hdcps:
+      deltaStepAlgoHDCPS<SrcEdgeTile>(graph, source,
+                                      SrcEdgeTilePushWrap{graph},
+                                      TileRangeFn());
+      break;
+  case deltaTile_reld:
+      deltaStepAlgoRELD<SrcEdgeTile>(graph, source,
+                                     SrcEdgeTilePushWrap{graph},
+                                     TileRangeFn());
+      break;
+  case deltaTile_minn:
+      deltaStepAlgoMinn<SrcEdgeTile>(graph, source,
+                                     SrcEdgeTilePushWrap{graph},
+                                     TileRangeFn());
+      break;
   case serDeltaTile:
     serDeltaAlgo<SrcEdgeTile>(graph, source, SrcEdgeTilePushWrap{graph},
                               TileRangeFn());
@@ -418,6 +418,7 @@ struct AsyncAlgo {
     typedef ChunkedFIFO<1> globNoChunk;
     typedef OrderedByIntegerMetric<Indexer,dChunk> OBIM;
     typedef AdaptiveOrderedByIntegerMetric<Indexer, dChunk, 0, true, false, CHUNK_SIZE> ADAPOBIM;
+    typedef AdaptiveOrderedByIntegerMetric<Indexer, dChunk, 0, true, false, CHUNK_SIZE, WorkItem, int, true, true> ADAPOBIM_UNMERGE;
     typedef OrderedByIntegerMetric<Indexer,dChunkedLIFO<64>> OBIM_LIFO;
     typedef OrderedByIntegerMetric<Indexer,dChunk, 4> OBIM_BLK4;
     typedef OrderedByIntegerMetric<Indexer,dChunk, 0, false> OBIM_NOBSP;
@@ -459,6 +460,8 @@ struct AsyncAlgo {
       Galois::for_each(WorkItem(source, 1), Process(graph), Galois::wl<OBIM>());
     else if (wl == "adap-obim")
       Galois::for_each(WorkItem(source, 1), Process(graph), Galois::wl<ADAPOBIM>());
+    else if (wl == "adap-obim-unmerge")
+      Galois::for_each(WorkItem(source, 1), Process(graph), Galois::wl<ADAPOBIM_UNMERGE>());
     else if (wl == "slobim")
       Galois::for_each(WorkItem(source, 1), Process(graph), Galois::wl<SLOBIM>());
     else if (wl == "slobim-nochunk")